@@ -0,0 +1,122 @@
+// Generated by tools/gen_assets.py from assets/jarAssets.txt; do not edit.
+#include <jarAssets.h>
+
+const uint8_t jarAssetBlob[ASSET_BLOB_SIZE] PROGMEM = {
+    // string BEEP_BROWNOUT
+    0x3c, 0x63, 0x38, 0x00,
+    // string BEEP_WELCOME
+    0x3e, 0x67, 0x33, 0x32, 0x3e, 0x3e, 0x63, 0x33, 0x32, 0x00,
+    // string BEEP_THANK_YOU
+    0x3e, 0x3e, 0x63, 0x33, 0x32, 0x3e, 0x67, 0x33, 0x32, 0x00,
+    // string FUGUE
+    0x21, 0x20, 0x56, 0x31, 0x30, 0x54, 0x31, 0x32, 0x30, 0x4f, 0x35, 0x4c,
+    0x31, 0x36, 0x61, 0x67, 0x61, 0x66, 0x61, 0x65, 0x61, 0x20, 0x64, 0x61,
+    0x63, 0x2b, 0x61, 0x64, 0x61, 0x65, 0x61, 0x20, 0x66, 0x61, 0x3c, 0x61,
+    0x61, 0x3c, 0x62, 0x61, 0x63, 0x23, 0x61, 0x20, 0x64, 0x61, 0x63, 0x23,
+    0x61, 0x64, 0x61, 0x65, 0x61, 0x20, 0x66, 0x4f, 0x36, 0x64, 0x63, 0x64,
+    0x3c, 0x62, 0x2d, 0x64, 0x3c, 0x61, 0x64, 0x3c, 0x67, 0x20, 0x64, 0x3c,
+    0x66, 0x2b, 0x64, 0x3c, 0x67, 0x64, 0x3c, 0x61, 0x64, 0x3c, 0x62, 0x2d,
+    0x20, 0x64, 0x3c, 0x64, 0x64, 0x3c, 0x65, 0x64, 0x3c, 0x66, 0x2b, 0x64,
+    0x3c, 0x67, 0x20, 0x64, 0x3c, 0x66, 0x2b, 0x64, 0x3c, 0x67, 0x64, 0x3c,
+    0x61, 0x64, 0x4c, 0x38, 0x4d, 0x53, 0x3c, 0x62, 0x2d, 0x64, 0x3c, 0x62,
+    0x2d, 0x64, 0x20, 0x4d, 0x4c, 0x65, 0x2d, 0x3c, 0x67, 0x65, 0x2d, 0x3c,
+    0x67, 0x20, 0x4d, 0x53, 0x63, 0x3c, 0x61, 0x63, 0x3c, 0x61, 0x20, 0x4d,
+    0x4c, 0x64, 0x3c, 0x66, 0x64, 0x3c, 0x66, 0x20, 0x4f, 0x35, 0x4d, 0x53,
+    0x62, 0x2d, 0x67, 0x62, 0x2d, 0x67, 0x4d, 0x4c, 0x3e, 0x63, 0x23, 0x65,
+    0x3e, 0x63, 0x23, 0x65, 0x20, 0x4d, 0x53, 0x20, 0x61, 0x66, 0x61, 0x66,
+    0x20, 0x4d, 0x4c, 0x20, 0x67, 0x63, 0x23, 0x67, 0x63, 0x23, 0x20, 0x4d,
+    0x53, 0x20, 0x66, 0x64, 0x66, 0x64, 0x20, 0x4d, 0x4c, 0x20, 0x65, 0x3c,
+    0x62, 0x2d, 0x65, 0x3c, 0x62, 0x2d, 0x4f, 0x36, 0x4c, 0x31, 0x36, 0x72,
+    0x61, 0x67, 0x61, 0x66, 0x61, 0x65, 0x61, 0x20, 0x64, 0x61, 0x63, 0x23,
+    0x61, 0x64, 0x61, 0x65, 0x61, 0x20, 0x66, 0x61, 0x3c, 0x61, 0x61, 0x3c,
+    0x62, 0x61, 0x63, 0x23, 0x61, 0x20, 0x64, 0x61, 0x63, 0x23, 0x61, 0x64,
+    0x61, 0x65, 0x61, 0x20, 0x66, 0x61, 0x65, 0x61, 0x64, 0x61, 0x63, 0x61,
+    0x3c, 0x62, 0x2d, 0x61, 0x63, 0x61, 0x64, 0x67, 0x3c, 0x62, 0x2d, 0x67,
+    0x20, 0x65, 0x67, 0x64, 0x67, 0x63, 0x67, 0x3c, 0x62, 0x2d, 0x67, 0x20,
+    0x3c, 0x61, 0x67, 0x3c, 0x62, 0x2d, 0x67, 0x63, 0x66, 0x3c, 0x61, 0x66,
+    0x20, 0x64, 0x66, 0x63, 0x66, 0x3c, 0x62, 0x2d, 0x66, 0x3c, 0x61, 0x66,
+    0x3c, 0x67, 0x66, 0x3c, 0x61, 0x66, 0x3c, 0x62, 0x2d, 0x65, 0x3c, 0x67,
+    0x65, 0x20, 0x63, 0x23, 0x65, 0x3c, 0x62, 0x2d, 0x65, 0x3c, 0x61, 0x65,
+    0x3c, 0x67, 0x65, 0x20, 0x3c, 0x66, 0x65, 0x3c, 0x67, 0x65, 0x3c, 0x61,
+    0x64, 0x3c, 0x66, 0x64, 0x4f, 0x35, 0x65, 0x3e, 0x65, 0x65, 0x3e, 0x65,
+    0x66, 0x3e, 0x64, 0x66, 0x3e, 0x64, 0x20, 0x62, 0x2d, 0x3e, 0x63, 0x23,
+    0x62, 0x2d, 0x3e, 0x63, 0x23, 0x61, 0x3e, 0x64, 0x66, 0x3e, 0x64, 0x20,
+    0x65, 0x3e, 0x65, 0x65, 0x3e, 0x65, 0x66, 0x3e, 0x64, 0x66, 0x3e, 0x64,
+    0x65, 0x3e, 0x64, 0x3e, 0x63, 0x23, 0x3e, 0x64, 0x62, 0x3e, 0x64, 0x3e,
+    0x63, 0x23, 0x62, 0x20, 0x3e, 0x63, 0x23, 0x61, 0x67, 0x61, 0x65, 0x67,
+    0x66, 0x65, 0x20, 0x66, 0x4f, 0x36, 0x64, 0x63, 0x23, 0x64, 0x66, 0x64,
+    0x63, 0x23, 0x3c, 0x62, 0x20, 0x63, 0x23, 0x34, 0x00,
+    // string MENU_ENCODERS
+    0x45, 0x6e, 0x63, 0x6f, 0x64, 0x65, 0x72, 0x73, 0x00,
+    // string MENU_LEDS
+    0x4c, 0x45, 0x44, 0x73, 0x00,
+    // string MENU_LINE_SENS
+    0x4c, 0x69, 0x6e, 0x65, 0x53, 0x65, 0x6e, 0x73, 0x00,
+    // string MENU_LINE_FAST
+    0x4c, 0x69, 0x6e, 0x65, 0x46, 0x61, 0x73, 0x74, 0x00,
+    // string MENU_PROX_SENS
+    0x50, 0x72, 0x6f, 0x78, 0x53, 0x65, 0x6e, 0x73, 0x00,
+    // string MENU_PROX_MAP
+    0x50, 0x72, 0x6f, 0x78, 0x4d, 0x61, 0x70, 0x00,
+    // string MENU_INERTIAL
+    0x49, 0x6e, 0x65, 0x72, 0x74, 0x69, 0x61, 0x6c, 0x00,
+    // string MENU_IMPACTS
+    0x49, 0x6d, 0x70, 0x61, 0x63, 0x74, 0x73, 0x00,
+    // string MENU_MOTORS
+    0x4d, 0x6f, 0x74, 0x6f, 0x72, 0x73, 0x00,
+    // string MENU_AUTOTUNE
+    0x41, 0x75, 0x74, 0x6f, 0x74, 0x75, 0x6e, 0x65, 0x00,
+    // string MENU_MUSIC
+    0x4d, 0x75, 0x73, 0x69, 0x63, 0x00,
+    // string MENU_POWER
+    0x50, 0x6f, 0x77, 0x65, 0x72, 0x00,
+    // string MENU_CALIB
+    0x43, 0x61, 0x6c, 0x69, 0x62, 0x00,
+    // string MENU_PARAMS
+    0x50, 0x61, 0x72, 0x61, 0x6d, 0x73, 0x00,
+    // string MENU_RECORD
+    0x52, 0x65, 0x63, 0x6f, 0x72, 0x64, 0x00,
+    // marquee FUGUE_TITLE
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x46, 0x75, 0x67, 0x75,
+    0x65, 0x20, 0x69, 0x6e, 0x20, 0x44, 0x20, 0x4d, 0x69, 0x6e, 0x6f, 0x72,
+    0x20, 0x2d, 0x20, 0x62, 0x79, 0x20, 0x4a, 0x2e, 0x53, 0x2e, 0x20, 0x42,
+    0x61, 0x63, 0x68, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00,
+    // glyph BACK_ARROW
+    0x00, 0x02, 0x01, 0x05, 0x09, 0x1e, 0x08, 0x04,
+    // glyph FORWARD_ARROWS
+    0x00, 0x04, 0x0a, 0x11, 0x04, 0x0a, 0x11, 0x00,
+    // glyph REVERSE_ARROWS
+    0x00, 0x11, 0x0a, 0x04, 0x11, 0x0a, 0x04, 0x00,
+    // glyph FORWARD_ARROWS_SOLID
+    0x00, 0x04, 0x0e, 0x1f, 0x04, 0x0e, 0x1f, 0x00,
+    // glyph REVERSE_ARROWS_SOLID
+    0x00, 0x1f, 0x0e, 0x04, 0x1f, 0x0e, 0x04, 0x00,
+};
+
+const JarAssetEntry jarAssetIndex[ASSET_COUNT] PROGMEM = {
+    {0, 3, 0},
+    {4, 9, 0},
+    {14, 9, 0},
+    {24, 440, 0},
+    {465, 8, 0},
+    {474, 4, 0},
+    {479, 8, 0},
+    {488, 8, 0},
+    {497, 8, 0},
+    {506, 7, 0},
+    {514, 8, 0},
+    {523, 7, 0},
+    {531, 6, 0},
+    {538, 8, 0},
+    {547, 5, 0},
+    {553, 5, 0},
+    {559, 5, 0},
+    {565, 6, 0},
+    {572, 6, 0},
+    {579, 47, 0},
+    {627, 8, 0},
+    {635, 8, 0},
+    {643, 8, 0},
+    {651, 8, 0},
+    {659, 8, 0},
+};
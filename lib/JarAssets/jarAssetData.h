@@ -0,0 +1,93 @@
+// Generated by tools/gen_assets.py from assets/jarAssets.txt; do not edit.
+#ifndef ASSET_DATA_H
+#define ASSET_DATA_H
+
+#include <Arduino.h>
+
+enum JarAssetId : uint8_t
+{
+  ASSET_BEEP_BROWNOUT,
+  ASSET_BEEP_WELCOME,
+  ASSET_BEEP_THANK_YOU,
+  ASSET_FUGUE,
+  ASSET_MENU_ENCODERS,
+  ASSET_MENU_LEDS,
+  ASSET_MENU_LINE_SENS,
+  ASSET_MENU_LINE_FAST,
+  ASSET_MENU_PROX_SENS,
+  ASSET_MENU_PROX_MAP,
+  ASSET_MENU_INERTIAL,
+  ASSET_MENU_IMPACTS,
+  ASSET_MENU_MOTORS,
+  ASSET_MENU_AUTOTUNE,
+  ASSET_MENU_MUSIC,
+  ASSET_MENU_POWER,
+  ASSET_MENU_CALIB,
+  ASSET_MENU_PARAMS,
+  ASSET_MENU_RECORD,
+  ASSET_FUGUE_TITLE,
+  ASSET_BACK_ARROW,
+  ASSET_FORWARD_ARROWS,
+  ASSET_REVERSE_ARROWS,
+  ASSET_FORWARD_ARROWS_SOLID,
+  ASSET_REVERSE_ARROWS_SOLID,
+  ASSET_COUNT
+};
+
+// Offsets are only defined for entries stored uncompressed.
+#define ASSET_BEEP_BROWNOUT_OFFSET 0
+#define ASSET_BEEP_BROWNOUT_LENGTH 3
+#define ASSET_BEEP_WELCOME_OFFSET 4
+#define ASSET_BEEP_WELCOME_LENGTH 9
+#define ASSET_BEEP_THANK_YOU_OFFSET 14
+#define ASSET_BEEP_THANK_YOU_LENGTH 9
+#define ASSET_FUGUE_OFFSET 24
+#define ASSET_FUGUE_LENGTH 440
+#define ASSET_MENU_ENCODERS_OFFSET 465
+#define ASSET_MENU_ENCODERS_LENGTH 8
+#define ASSET_MENU_LEDS_OFFSET 474
+#define ASSET_MENU_LEDS_LENGTH 4
+#define ASSET_MENU_LINE_SENS_OFFSET 479
+#define ASSET_MENU_LINE_SENS_LENGTH 8
+#define ASSET_MENU_LINE_FAST_OFFSET 488
+#define ASSET_MENU_LINE_FAST_LENGTH 8
+#define ASSET_MENU_PROX_SENS_OFFSET 497
+#define ASSET_MENU_PROX_SENS_LENGTH 8
+#define ASSET_MENU_PROX_MAP_OFFSET 506
+#define ASSET_MENU_PROX_MAP_LENGTH 7
+#define ASSET_MENU_INERTIAL_OFFSET 514
+#define ASSET_MENU_INERTIAL_LENGTH 8
+#define ASSET_MENU_IMPACTS_OFFSET 523
+#define ASSET_MENU_IMPACTS_LENGTH 7
+#define ASSET_MENU_MOTORS_OFFSET 531
+#define ASSET_MENU_MOTORS_LENGTH 6
+#define ASSET_MENU_AUTOTUNE_OFFSET 538
+#define ASSET_MENU_AUTOTUNE_LENGTH 8
+#define ASSET_MENU_MUSIC_OFFSET 547
+#define ASSET_MENU_MUSIC_LENGTH 5
+#define ASSET_MENU_POWER_OFFSET 553
+#define ASSET_MENU_POWER_LENGTH 5
+#define ASSET_MENU_CALIB_OFFSET 559
+#define ASSET_MENU_CALIB_LENGTH 5
+#define ASSET_MENU_PARAMS_OFFSET 565
+#define ASSET_MENU_PARAMS_LENGTH 6
+#define ASSET_MENU_RECORD_OFFSET 572
+#define ASSET_MENU_RECORD_LENGTH 6
+#define ASSET_FUGUE_TITLE_OFFSET 579
+#define ASSET_FUGUE_TITLE_LENGTH 47
+#define ASSET_BACK_ARROW_OFFSET 627
+#define ASSET_BACK_ARROW_LENGTH 8
+#define ASSET_FORWARD_ARROWS_OFFSET 635
+#define ASSET_FORWARD_ARROWS_LENGTH 8
+#define ASSET_REVERSE_ARROWS_OFFSET 643
+#define ASSET_REVERSE_ARROWS_LENGTH 8
+#define ASSET_FORWARD_ARROWS_SOLID_OFFSET 651
+#define ASSET_FORWARD_ARROWS_SOLID_LENGTH 8
+#define ASSET_REVERSE_ARROWS_SOLID_OFFSET 659
+#define ASSET_REVERSE_ARROWS_SOLID_LENGTH 8
+
+#define ASSET_BLOB_SIZE 667
+
+extern const uint8_t jarAssetBlob[ASSET_BLOB_SIZE] PROGMEM;
+
+#endif
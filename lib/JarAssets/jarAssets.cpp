@@ -0,0 +1,47 @@
+#include <jarAssets.h>
+
+#ifndef ASSETS_CPP
+#define ASSETS_CPP
+
+uint16_t JarAssets::length(JarAssetId id)
+{
+    return pgm_read_word(&jarAssetIndex[id].length);
+}
+
+bool JarAssets::compressed(JarAssetId id)
+{
+    return pgm_read_byte(&jarAssetIndex[id].flags) & ASSET_FLAG_RLE;
+}
+
+const char *JarAssets::data(JarAssetId id)
+{
+    return (const char *)jarAssetBlob + pgm_read_word(&jarAssetIndex[id].offset);
+}
+
+uint16_t JarAssets::copy(JarAssetId id, void *buffer, uint16_t size)
+{
+    const char *src = data(id);
+    uint8_t *dest = (uint8_t *)buffer;
+    uint16_t count = min(length(id), size);
+
+    if (!compressed(id))
+    {
+        memcpy_P(dest, src, count);
+        return count;
+    }
+
+    // Run-length encoded as (count, byte) pairs.
+    uint16_t done = 0;
+    while (done < count)
+    {
+        uint8_t run = pgm_read_byte(src++);
+        uint8_t value = pgm_read_byte(src++);
+        while (run-- && done < count)
+        {
+            dest[done++] = value;
+        }
+    }
+    return count;
+}
+
+#endif
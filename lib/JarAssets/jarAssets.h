@@ -0,0 +1,81 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <Arduino.h>
+#include <jarAssetData.h>
+
+// The assets themselves are generated from assets/jarAssets.txt by
+// tools/gen_assets.py into jarAssetData.h/.cpp.
+
+#define ASSET_FLAG_RLE 1
+
+// Where an asset is in the blob, its decoded length (without the
+// terminating NUL of strings) and how it is stored.
+struct JarAssetEntry
+{
+  uint16_t offset;
+  uint16_t length;
+  uint8_t flags;
+};
+
+extern const JarAssetEntry jarAssetIndex[ASSET_COUNT] PROGMEM;
+
+// Flash address of an uncompressed asset. These are constant, so they
+// can be used in static initializers, e.g. for menu items.
+#define JAR_ASSET(name) ((const char *)(jarAssetBlob + ASSET_##name##_OFFSET))
+#define JAR_ASSET_F(name) ((const __FlashStringHelper *)JAR_ASSET(name))
+
+class JarAssets
+{
+public:
+  static uint16_t length(JarAssetId id);
+  static bool compressed(JarAssetId id);
+
+  // Flash address of the stored bytes.
+  static const char *data(JarAssetId id);
+
+  // Copies an asset into RAM, decoding it if needed. Returns the
+  // number of bytes copied.
+  static uint16_t copy(JarAssetId id, void *buffer, uint16_t size);
+};
+
+// Scrolls a marquee asset through a window of the LCD. The length
+// comes from the index, so nothing is scanned while scrolling.
+class JarMarquee
+{
+public:
+  explicit JarMarquee(JarAssetId id, uint8_t width = 8)
+    : text(JarAssets::data(id)), length(JarAssets::length(id)), width(width), pos(0)
+  {
+  }
+
+  void reset() { pos = 0; }
+
+  // Prints the current window at the cursor position.
+  template <class Lcd>
+  void render(Lcd &lcd)
+  {
+    for (uint8_t i = 0; i < width; i++)
+    {
+      lcd.print((char)pgm_read_byte(text + pos + i));
+    }
+  }
+
+  // Moves one character on, starting over after the window has
+  // shown the last character.
+  void advance()
+  {
+    if (++pos + width > length)
+    {
+      pos = 0;
+    }
+  }
+
+private:
+  const char *text;
+  uint16_t length;
+  uint8_t width;
+  uint16_t pos;
+};
+
+#endif
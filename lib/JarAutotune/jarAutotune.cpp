@@ -0,0 +1,110 @@
+#include <jarAutotune.h>
+#include <jarFixed.h>
+
+#ifndef AUTOTUNE_CPP
+#define AUTOTUNE_CPP
+
+JarAutotune::JarAutotune(int16_t setpoint, int16_t bias, int16_t relay, int16_t hysteresis)
+{
+    this->setpoint = setpoint;
+    this->bias = bias;
+    this->relay = relay;
+    this->hysteresis = hysteresis;
+    begin(0);
+}
+
+void JarAutotune::begin(uint16_t now)
+{
+    state = RUNNING;
+    high = true;
+    cycles = 0;
+    lastSwitch = lastRise = now;
+    peak = -32768;
+    trough = 32767;
+    periodSum = ampSum = 0;
+    period = amp = 0;
+    ku = 0;
+}
+
+int16_t JarAutotune::update(int16_t speed, uint16_t now)
+{
+    if (state != RUNNING)
+    {
+        return 0;
+    }
+
+    if ((uint16_t)(now - lastSwitch) > AUTOTUNE_TIMEOUT_MS)
+    {
+        state = FAILED;
+        return 0;
+    }
+
+    peak = max(peak, speed);
+    trough = min(trough, speed);
+
+    if (high && speed > setpoint + hysteresis)
+    {
+        high = false;
+        lastSwitch = now;
+    }
+    else if (!high && speed < setpoint - hysteresis)
+    {
+        // A full cycle ends when the output goes high again.
+        high = true;
+        lastSwitch = now;
+
+        if (cycles >= AUTOTUNE_SETTLE_CYCLES)
+        {
+            periodSum += (uint16_t)(now - lastRise);
+            ampSum += peak - trough;
+        }
+        lastRise = now;
+        peak = -32768;
+        trough = 32767;
+
+        if (++cycles == AUTOTUNE_SETTLE_CYCLES + AUTOTUNE_MEASURE_CYCLES)
+        {
+            finish();
+            return 0;
+        }
+    }
+
+    return high ? bias + relay : bias - relay;
+}
+
+void JarAutotune::finish()
+{
+    // ampSum holds peak-to-peak swings, twice the amplitude per
+    // cycle.
+    period = periodSum / AUTOTUNE_MEASURE_CYCLES;
+    amp = (ampSum + AUTOTUNE_MEASURE_CYCLES) / (2 * AUTOTUNE_MEASURE_CYCLES);
+
+    if (ampSum == 0 || period == 0)
+    {
+        state = FAILED;
+        return;
+    }
+
+    // Ku = 4 relay / (pi amp), in Q8.8; 1/pi = 163/512, and
+    // amp = ampSum / (2 cycles).
+    ku = JarFixed::sat16((int32_t)relay * 4 * 163 * AUTOTUNE_MEASURE_CYCLES / ampSum);
+    state = DONE;
+}
+
+// Ziegler-Nichols: Kp = 0.6 Ku, Ti = Tu / 2, Td = Tu / 8.
+int16_t JarAutotune::kp() const
+{
+    return JarFixed::sat16((int32_t)ku * 3 / 5);
+}
+
+int16_t JarAutotune::ki(uint16_t samplePeriodMs) const
+{
+    return JarFixed::sat16((int32_t)kp() * 2 * samplePeriodMs / period);
+}
+
+int16_t JarAutotune::kd(uint16_t samplePeriodMs) const
+{
+    return JarFixed::sat16((int32_t)kp() * period / 8 / samplePeriodMs);
+}
+
+#endif
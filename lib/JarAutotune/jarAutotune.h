@@ -0,0 +1,77 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <Arduino.h>
+
+// Relay cycles that are ignored while the oscillation settles, and
+// cycles that are averaged after that.
+#define AUTOTUNE_SETTLE_CYCLES 2
+#define AUTOTUNE_MEASURE_CYCLES 4
+
+// Give up if a relay half cycle takes longer than this.
+#define AUTOTUNE_TIMEOUT_MS 3000
+
+// Relay feedback (Astrom-Hagglund) identification of a speed loop.
+//
+// The output switches between bias + relay and bias - relay whenever
+// the measured speed crosses the setpoint (with hysteresis). The
+// loop then oscillates at its ultimate period Tu; with the amplitude
+// a of the speed oscillation the ultimate gain is Ku = 4 relay / (pi a).
+// PID gains follow from the Ziegler-Nichols rules.
+//
+// This class only does the math: the caller measures the speed,
+// passes it to update() once per sample period and drives the
+// motor with the result, so it runs the same against a simulated
+// motor.
+class JarAutotune
+{
+public:
+  JarAutotune(int16_t setpoint, int16_t bias, int16_t relay, int16_t hysteresis);
+
+  void begin(uint16_t now);
+
+  // Takes the speed measured at time now (ms) and returns the motor
+  // command for the next period.
+  int16_t update(int16_t speed, uint16_t now);
+
+  bool done() const { return state == DONE; }
+  bool failed() const { return state == FAILED; }
+
+  // Results, valid once done() is true: the ultimate period in ms,
+  // the oscillation amplitude in speed units (rounded) and the
+  // ultimate gain in Q8.8. The gain is computed from the summed
+  // peak-to-peak swings, so it keeps the half count a low-resolution
+  // speed loses when halved.
+  uint16_t periodMs() const { return period; }
+  uint16_t amplitude() const { return amp; }
+  int16_t ultimateGain() const { return ku; }
+
+  // Discrete PID gains in Q8.8 for a controller updated every
+  // samplePeriodMs, with the integral and derivative terms summed
+  // and differenced per sample.
+  int16_t kp() const;
+  int16_t ki(uint16_t samplePeriodMs) const;
+  int16_t kd(uint16_t samplePeriodMs) const;
+
+private:
+  enum State
+  {
+    RUNNING,
+    DONE,
+    FAILED
+  };
+
+  void finish();
+
+  int16_t setpoint, bias, relay, hysteresis;
+  State state;
+  bool high;
+  uint8_t cycles;
+  uint16_t lastSwitch, lastRise;
+  int16_t peak, trough;
+  uint32_t periodSum, ampSum;
+  uint16_t period, amp;
+  int16_t ku;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include <Arduino.h>
+
+// How often read() retries before giving up when a publish keeps
+// interrupting it. Only matters for readers in an interrupt, which
+// can be interrupting the producer halfway through a publish.
+#define BUS_READ_TRIES 4
+
+// Keeps the compiler from moving memory accesses across this point.
+// The AVR has a single core, so no hardware fence is needed.
+#define BUS_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// The latest value of a sample, written by a single producer and
+// read by any number of consumers without disabling interrupts.
+//
+// The sequence number is odd while a publish is in progress; a
+// reader copies the value and retries if the sequence changed in
+// the meantime. It is 8 bits wide so it is read atomically on the
+// AVR. Zero means nothing was published yet, so it is skipped when
+// the sequence wraps around.
+template <class T>
+class JarSlot
+{
+public:
+  JarSlot() : seq(0) {}
+
+  void publish(const T &sample)
+  {
+    uint8_t s = seq;
+    seq = s + 1;
+    BUS_BARRIER();
+    memcpy((void *)&value, &sample, sizeof(T));
+    BUS_BARRIER();
+    s += 2;
+    seq = s ? s : 2;
+  }
+
+  // Copies the latest sample. Returns false if nothing has been
+  // published yet or no consistent copy could be made.
+  bool read(T &sample) const
+  {
+    for (uint8_t tries = 0; tries < BUS_READ_TRIES; tries++)
+    {
+      uint8_t before = seq;
+      if (before & 1)
+      {
+        continue;
+      }
+      BUS_BARRIER();
+      memcpy(&sample, (const void *)&value, sizeof(T));
+      BUS_BARRIER();
+      if (seq == before)
+      {
+        return before != 0;
+      }
+    }
+    return false;
+  }
+
+  // Changes with every publish; compare with an earlier value to
+  // see whether there is a new sample.
+  uint8_t sequence() const { return seq; }
+
+private:
+  volatile uint8_t seq;
+  volatile T value;
+};
+
+// A ring of samples (N a power of two, at most 128) for consumers
+// that must not miss any. Every consumer keeps its own cursor, so one
+// producer can feed several consumers. The slot the producer writes
+// next is never read, as a reader in an interrupt may have stopped
+// the producer halfway through it, so the last N - 1 samples can be
+// read.
+template <class T, uint8_t N>
+class JarStream
+{
+public:
+  JarStream() : head(0)
+  {
+    static_assert(N <= 128 && (N & (N - 1)) == 0, "N must be a power of two up to 128");
+  }
+
+  void publish(const T &sample)
+  {
+    memcpy((void *)&buffer[head & (N - 1)], &sample, sizeof(T));
+    BUS_BARRIER();
+    head = head + 1;
+  }
+
+  class Reader
+  {
+  public:
+    explicit Reader(const JarStream &stream) : lost(0), stream(stream), cursor(stream.head) {}
+
+    // Copies the next sample. Returns false if there is none. If the
+    // producer overtook this reader, the oldest samples still in the
+    // ring are returned and the skipped ones counted in lost, which
+    // stops at 0xFFFF rather than wrapping.
+    bool next(T &sample)
+    {
+      while (1)
+      {
+        uint8_t head = stream.head;
+        if (head == cursor)
+        {
+          return false;
+        }
+        if ((uint8_t)(head - cursor) >= N)
+        {
+          uint8_t skipped = (uint8_t)(head - cursor) - (N - 1);
+          lost = (lost > 0xFFFF - skipped) ? 0xFFFF : lost + skipped;
+          cursor = head - (N - 1);
+        }
+        BUS_BARRIER();
+        memcpy(&sample, (const void *)&stream.buffer[cursor & (N - 1)], sizeof(T));
+        BUS_BARRIER();
+
+        // Retry if the slot was overwritten while it was copied.
+        if ((uint8_t)(stream.head - cursor) < N)
+        {
+          cursor++;
+          return true;
+        }
+      }
+    }
+
+    uint16_t lost;
+
+  private:
+    const JarStream &stream;
+    uint8_t cursor;
+  };
+
+private:
+  volatile uint8_t head;
+  volatile T buffer[N];
+};
+
+// Samples published on the bus. time is millis() when the sample
+// was taken.
+struct JarLineSample
+{
+  uint16_t time;
+  uint16_t values[3];
+  bool emittersOn;
+};
+
+struct JarProxSample
+{
+  uint16_t time;
+  uint8_t counts[6];
+};
+
+struct JarImuSample
+{
+  uint16_t time;
+  int16_t accel[3];
+  int16_t gyro[3];
+};
+
+// Encoder counts are totals since power-up, so every consumer can
+// work out its own differences.
+struct JarEncoderSample
+{
+  uint16_t time;
+  int16_t left;
+  int16_t right;
+};
+
+struct JarBatterySample
+{
+  uint16_t time;
+  uint16_t millivolts;
+};
+
+// A collision or tap detected by the accelerometer. magnitude is
+// the acceleration beyond gravity in mg, direction the angle it
+// points to in the accelerometer's x-y plane (256 per turn).
+struct JarImpactEvent
+{
+  uint16_t time;
+  uint16_t magnitude;
+  uint8_t direction;
+  uint8_t source;
+};
+
+// All sensor data shared between producers and consumers.
+struct JarBus
+{
+  JarSlot<JarLineSample> line;
+  JarSlot<JarProxSample> prox;
+  JarSlot<JarImuSample> imu;
+  JarSlot<JarEncoderSample> encoders;
+  JarSlot<JarBatterySample> battery;
+  JarStream<JarImpactEvent, 8> impacts;
+};
+
+#endif
@@ -1,20 +1,52 @@
 #ifndef BUTTON_H
 #define BUTTON_H
 
+#include <Arduino.h>
+
 const char beepButtonA[] PROGMEM = "!c32";
 const char beepButtonB[] PROGMEM = "!e32";
 const char beepButtonC[] PROGMEM = "!g32";
 
+// The three user buttons and the buzzer that confirms a press.
+// The hardware classes are template parameters so every call
+// inlines on the AVR; on the Zumo use
+// JarButton<Zumo32U4Buzzer, Zumo32U4ButtonA, Zumo32U4ButtonB, Zumo32U4ButtonC>.
+template <class Buzzer, class ButtonA, class ButtonB, class ButtonC>
 class JarButton
 {
 public:
-  static Zumo32U4Buzzer buzzer;
-  static char monitor();
-  static bool aIsPressed();
-  static bool bIsPressed();
-  static bool cIsPressed();
+  Buzzer buzzer;
+  ButtonA buttonA;
+  ButtonB buttonB;
+  ButtonC buttonC;
+
+  // Returns 'A', 'B' or 'C' for a new debounced press, 0 otherwise.
+  char monitor()
+  {
+    if (buttonA.getSingleDebouncedPress())
+    {
+      buzzer.playFromProgramSpace(beepButtonA);
+      return 'A';
+    }
+
+    if (buttonB.getSingleDebouncedPress())
+    {
+      buzzer.playFromProgramSpace(beepButtonB);
+      return 'B';
+    }
+
+    if (buttonC.getSingleDebouncedPress())
+    {
+      buzzer.playFromProgramSpace(beepButtonC);
+      return 'C';
+    }
+
+    return 0;
+  }
 
-private:
+  bool aIsPressed() { return buttonA.isPressed(); }
+  bool bIsPressed() { return buttonB.isPressed(); }
+  bool cIsPressed() { return buttonC.isPressed(); }
 };
 
 #endif
@@ -0,0 +1,227 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <Arduino.h>
+#include <jarBus.h>
+#include <jarFixed.h>
+
+// LSM303D accelerometer registers used here.
+#define LSM303D_CTRL0 0x1F
+#define LSM303D_CTRL1 0x20
+#define LSM303D_CTRL2 0x21
+#define LSM303D_CTRL3 0x22
+#define LSM303D_CTRL5 0x24
+#define LSM303D_FIFO_CTRL 0x2E
+#define LSM303D_FIFO_SRC 0x2F
+#define LSM303D_IG_CFG1 0x30
+#define LSM303D_IG_SRC1 0x31
+#define LSM303D_IG_THS1 0x32
+#define LSM303D_IG_DUR1 0x33
+#define LSM303D_CLICK_CFG 0x38
+#define LSM303D_CLICK_SRC 0x39
+#define LSM303D_CLICK_THS 0x3A
+#define LSM303D_TIME_LIMIT 0x3B
+
+// Sources of an impact event. IMPACT_UNSIGNED is set when the
+// direction is only known up to a half turn, IMPACT_AT_LEAST when the
+// magnitude is the threshold that was crossed rather than a
+// measured peak.
+#define IMPACT_CLICK 1
+#define IMPACT_THRESHOLD 2
+#define IMPACT_UNSIGNED 4
+#define IMPACT_AT_LEAST 8
+
+// Accelerometer setup: 400 Hz, all axes, +/-4 g full scale, where
+// one count is 0.122 mg and one threshold step is 4 g / 128.
+#define COLLISION_CTRL1 0x87
+#define COLLISION_CTRL2 0x08
+#define COLLISION_MG_PER_THS 31
+
+// CTRL0 bits: FIFO enable, and the high-pass filter for the click
+// and the threshold generators, which takes gravity and slow tilts
+// out of what they compare with the thresholds.
+#define COLLISION_CTRL0_FIFO 0x40
+#define COLLISION_CTRL0_HP 0x06
+
+// Detects collisions and taps with the LSM303D's click and
+// threshold interrupt generators, which watch the accelerometer at
+// 400 Hz in the sensor itself, behind its high-pass filter. The
+// threshold event is latched.
+//
+// The interrupt pins of the LSM303D are not wired to the AVR on the
+// Zumo 32U4, so by default poll() reads the two event registers,
+// which is much cheaper than reading samples fast enough to catch a
+// bump. If INT1 is wired to a pin, call interrupt() from its ISR and
+// poll() only talks to the sensor after an interrupt.
+//
+// Without FIFO capture an event only says which axes crossed the
+// threshold and, for clicks, to which side, so its magnitude is the
+// threshold that was crossed, marked IMPACT_AT_LEAST, and its
+// direction one of eight. The threshold generator compares absolute
+// values, so an event it saw alone points to the positive side and is
+// marked IMPACT_UNSIGNED.
+//
+// With FIFO capture on, the FIFO keeps the last 32 samples (80 ms)
+// and an event reports the peak over that window, measured from the
+// baseline. Reading the FIFO takes the samples away from everyone
+// else, so only use it when nothing else reads the accelerometer.
+//
+// Imu is e.g. LSM303 from the Pololu library, already initialized.
+template <class Imu>
+class JarCollision
+{
+public:
+  explicit JarCollision(Imu &imu)
+    : imu(imu), usePin(false), pending(false), fifo(false), clickThs(0), thresholdThs(0)
+  {
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      baseline[i] = 0;
+    }
+  }
+
+  // Can be called again to apply new thresholds.
+  void begin(uint16_t clickMg, uint16_t thresholdMg, bool useFifo = false, bool useInterruptPin = false)
+  {
+    fifo = useFifo;
+    usePin = useInterruptPin;
+    clickThs = min(clickMg / COLLISION_MG_PER_THS, 127);
+    thresholdThs = min(thresholdMg / COLLISION_MG_PER_THS, 127);
+
+    imu.writeReg(LSM303D_CTRL1, COLLISION_CTRL1);
+    imu.writeReg(LSM303D_CTRL2, COLLISION_CTRL2);
+
+    // Single clicks on every axis, at most 20 ms (8 samples) long.
+    imu.writeReg(LSM303D_CLICK_CFG, 0x15);
+    imu.writeReg(LSM303D_CLICK_THS, clickThs);
+    imu.writeReg(LSM303D_TIME_LIMIT, 8);
+
+    // High events on any axis, latched until IG_SRC1 is read.
+    imu.writeReg(LSM303D_IG_CFG1, 0x2A);
+    imu.writeReg(LSM303D_IG_THS1, thresholdThs);
+    imu.writeReg(LSM303D_IG_DUR1, 0);
+    imu.writeReg(LSM303D_CTRL5, imu.readReg(LSM303D_CTRL5) | 0x01);
+
+    // Route both to INT1 in case it is wired.
+    imu.writeReg(LSM303D_CTRL3, 0x60);
+
+    // Stream mode, or bypass to empty the FIFO.
+    imu.writeReg(LSM303D_FIFO_CTRL, fifo ? 0x40 : 0x00);
+    uint8_t ctrl0 = imu.readReg(LSM303D_CTRL0) & ~COLLISION_CTRL0_FIFO;
+    imu.writeReg(LSM303D_CTRL0, ctrl0 | COLLISION_CTRL0_HP | (fifo ? COLLISION_CTRL0_FIFO : 0));
+  }
+
+  // Call from the ISR of the pin INT1 is wired to.
+  void interrupt()
+  {
+    pending = true;
+  }
+
+  // Gravity and slow movements, subtracted from the FIFO samples.
+  // Feed it regular accelerometer readings.
+  void updateBaseline(const int16_t accel[3])
+  {
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      baseline[i] += ((int32_t)accel[i] - baseline[i]) >> 3;
+    }
+  }
+
+  // Checks for a new event and publishes it. Returns true if there
+  // was one.
+  bool poll(JarStream<JarImpactEvent, 8> &impacts)
+  {
+    if (usePin)
+    {
+      if (!pending) { return false; }
+      pending = false;
+    }
+
+    uint8_t click = imu.readReg(LSM303D_CLICK_SRC);
+    uint8_t threshold = imu.readReg(LSM303D_IG_SRC1);
+    uint8_t source = 0;
+    if (click & 0x40) { source |= IMPACT_CLICK; }
+    if (threshold & 0x40) { source |= IMPACT_THRESHOLD; }
+    if (!source) { return false; }
+
+    JarImpactEvent event;
+    event.time = millis();
+    event.source = source;
+    event.magnitude = 0;
+    event.direction = 0;
+
+    if (fifo)
+    {
+      peakFromFifo(event);
+    }
+    else
+    {
+      fromSources(event, click, threshold);
+    }
+
+    impacts.publish(event);
+    return true;
+  }
+
+private:
+  // CLICK_SRC has a bit per axis and one sign for all of them;
+  // IG_SRC1 has a high bit per axis (XH 0x02, YH 0x08).
+  void fromSources(JarImpactEvent &event, uint8_t click, uint8_t threshold)
+  {
+    int8_t x = 0, y = 0;
+    uint8_t ths = 0;
+    if (event.source & IMPACT_CLICK)
+    {
+      int8_t sign = (click & 0x08) ? -1 : 1;
+      if (click & 0x01) { x = sign; }
+      if (click & 0x02) { y = sign; }
+      ths = clickThs;
+    }
+    if (event.source & IMPACT_THRESHOLD)
+    {
+      if (!(event.source & IMPACT_CLICK))
+      {
+        if (threshold & 0x02) { x = 1; }
+        if (threshold & 0x08) { y = 1; }
+        event.source |= IMPACT_UNSIGNED;
+      }
+      ths = max(ths, thresholdThs);
+    }
+
+    event.source |= IMPACT_AT_LEAST;
+    event.magnitude = ths * COLLISION_MG_PER_THS;
+    event.direction = (x || y) ? JarFixed::atan2(y, x) >> 8 : 0;
+  }
+
+  void peakFromFifo(JarImpactEvent &event)
+  {
+    uint8_t samples = imu.readReg(LSM303D_FIFO_SRC) & 0x1F;
+    for (uint8_t i = 0; i < samples; i++)
+    {
+      imu.readAcc();
+      // A sample and the baseline can be up to 4 g apart in
+      // opposite directions, which does not fit 16 bits.
+      int32_t dx = (int32_t)imu.a.x - baseline[0];
+      int32_t dy = (int32_t)imu.a.y - baseline[1];
+      int32_t dz = (int32_t)imu.a.z - baseline[2];
+
+      // Counts are 0.122 mg, so mg = counts / 8 is close enough.
+      int16_t x = dx >> 3, y = dy >> 3, z = dz >> 3;
+      uint16_t magnitude = JarFixed::norm(x, y, z);
+      if (magnitude >= event.magnitude)
+      {
+        event.magnitude = magnitude;
+        event.direction = JarFixed::atan2(y, x) >> 8;
+      }
+    }
+  }
+
+  Imu &imu;
+  bool usePin;
+  volatile bool pending;
+  bool fifo;
+  uint8_t clickThs, thresholdThs;
+  int16_t baseline[3];
+};
+
+#endif
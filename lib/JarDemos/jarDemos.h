@@ -0,0 +1,363 @@
+#ifndef DEMOS_H
+#define DEMOS_H
+
+#include <Arduino.h>
+#include <jarBus.h>
+
+// The parts of the demos in main.cpp that turn bus samples and
+// buttons into LCD frames and motor efforts. They touch no hardware
+// beyond the Lcd, Buttons and motor output they are given, so a trace
+// recorded on the robot can be replayed through them on the host.
+//
+// Nothing is drawn before the first sample arrives.
+//
+// Lcd is e.g. Zumo32U4LCD; the bar graphs expect the custom
+// characters of loadCustomCharactersBarGraph() in main.cpp, the motor
+// panel those of loadCustomCharactersMotorDirs().
+
+// Prints a bar of 0 to 8 pixels.
+template <class Lcd>
+void jarPrintBar(Lcd &lcd, uint8_t height)
+{
+  if (height > 8) { height = 8; }
+  static const char barChars[] = {' ', 0, 1, 2, 3, 4, 5, 6, -128};
+  lcd.print(barChars[height]);
+}
+
+// Given 3 readings for axes x, y, and z, prints the sign and axis of
+// the largest reading unless it is below the given threshold.
+template <class Lcd>
+void jarPrintLargestAxis(Lcd &lcd, int16_t x, int16_t y, int16_t z, uint16_t threshold)
+{
+  int16_t largest = x;
+  char axis = 'X';
+
+  if (abs(y) > abs(largest))
+  {
+    largest = y;
+    axis = 'Y';
+  }
+  if (abs(z) > abs(largest))
+  {
+    largest = z;
+    axis = 'Z';
+  }
+
+  if (abs(largest) < threshold)
+  {
+    lcd.print("  ");
+  }
+  else
+  {
+    bool positive = (largest > 0);
+    lcd.print(positive ? '+' : '-');
+    lcd.print(axis);
+  }
+}
+
+// Bar graphs of the three line sensors and whether the emitters
+// were on.
+template <class Lcd>
+class JarLineView
+{
+public:
+  explicit JarLineView(Lcd &lcd) : lcd(lcd) {}
+
+  void step(const JarBus &bus)
+  {
+    JarLineSample line;
+    if (!bus.line.read(line)) { return; }
+
+    lcd.gotoXY(1, 0);
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      uint8_t barHeight = map(line.values[i], 0, 2000, 0, 8);
+      jarPrintBar(lcd, barHeight);
+      lcd.print(' ');
+    }
+
+    // Display an indicator of whether emitters are on or
+    // off.
+    lcd.gotoXY(7, 1);
+    if (!line.emittersOn)
+    {
+      lcd.print('\xa5');  // centered dot
+    }
+    else
+    {
+      lcd.print('*');
+    }
+  }
+
+private:
+  Lcd &lcd;
+};
+
+// Bar graphs of the six proximity counts on the first line.
+template <class Lcd>
+class JarProxView
+{
+public:
+  explicit JarProxView(Lcd &lcd) : lcd(lcd) {}
+
+  void step(const JarBus &bus)
+  {
+    JarProxSample prox;
+    if (!bus.prox.read(prox)) { return; }
+
+    lcd.gotoXY(0, 0);
+    for (uint8_t i = 0; i < 6; i++)
+    {
+      jarPrintBar(lcd, prox.counts[i]);
+      if (i == 1 || i == 3) { lcd.print(' '); }
+    }
+  }
+
+private:
+  Lcd &lcd;
+};
+
+// The direction of the largest rotation rate and the up direction
+// from the accelerometer (assuming gravity is the dominant force
+// acting on the Zumo).
+template <class Lcd>
+class JarInertialView
+{
+public:
+  explicit JarInertialView(Lcd &lcd) : lcd(lcd) {}
+
+  void step(const JarBus &bus, int16_t gyroBiasZ, uint16_t gyroThreshold, uint16_t accelThreshold)
+  {
+    JarImuSample imu;
+    if (!bus.imu.read(imu)) { return; }
+
+    lcd.gotoXY(6, 0);
+    jarPrintLargestAxis(lcd, imu.gyro[0], imu.gyro[1], imu.gyro[2] - gyroBiasZ, gyroThreshold);
+    lcd.gotoXY(6, 1);
+    jarPrintLargestAxis(lcd, imu.accel[0], imu.accel[1], imu.accel[2], accelThreshold);
+  }
+
+private:
+  Lcd &lcd;
+};
+
+// Motor test panel. Holding button A or C causes the left or right
+// motor to accelerate; releasing the button causes the motor to
+// decelerate. Tapping the button while the motor is not running
+// turns that wheel once at a low effort, to check the counts per
+// revolution.
+//
+// If showEncoders is true, encoder counts are displayed on the first
+// line of the LCD; otherwise, an instructional message is shown.
+//
+// Output is e.g. JarMotorOutput.
+template <class Lcd, class Buttons, class Output>
+class JarMotorPanel
+{
+public:
+  JarMotorPanel(Lcd &lcd, Buttons &buttons, Output &output, bool showEncoders)
+    : lcd(lcd), buttons(buttons), output(output), showEncoders(showEncoders)
+  {
+  }
+
+  void begin(const JarBus &bus, uint16_t now)
+  {
+    leftSpeed = rightSpeed = 0;
+    leftDir = rightDir = 1;
+    lastUpdateTime = now - 100;
+    btnCountA = btnCountC = instructCount = 0;
+    encCountsLeft = encCountsRight = 0;
+    turning = TURN_NONE;
+    if (!bus.encoders.read(lastEnc))
+    {
+      memset(&lastEnc, 0, sizeof(lastEnc));
+    }
+  }
+
+  // One pass of the demo loop. Returns false while a wheel is being
+  // turned once and did not move since the last pass, so the caller
+  // can leave a blocked wheel to the watchdog.
+  bool step(const JarBus &bus, uint16_t now, uint16_t periodMs, int16_t countsPerRev)
+  {
+    char buf[7];
+    JarEncoderSample enc;
+    if (!bus.encoders.read(enc)) { enc = lastEnc; }
+    int16_t countsLeft = enc.left - lastEnc.left;
+    int16_t countsRight = enc.right - lastEnc.right;
+    lastEnc = enc;
+
+    if (turning != TURN_NONE)
+    {
+      return turnStep(turning == TURN_LEFT ? countsLeft : countsRight, countsPerRev);
+    }
+
+    encCountsLeft += countsLeft;
+    if (encCountsLeft < 0) { encCountsLeft += 1000; }
+    if (encCountsLeft > 999) { encCountsLeft -= 1000; }
+
+    encCountsRight += countsRight;
+    if (encCountsRight < 0) { encCountsRight += 1000; }
+    if (encCountsRight > 999) { encCountsRight -= 1000; }
+
+    // Update the LCD and motors every MotorMs (50 ms by default).
+    if ((uint16_t)(now - lastUpdateTime) <= periodMs)
+    {
+      return true;
+    }
+    lastUpdateTime = now;
+
+    lcd.gotoXY(0, 0);
+    if (showEncoders)
+    {
+      sprintf(buf, "%03d", encCountsLeft);
+      lcd.print(buf);
+      lcd.gotoXY(5, 0);
+      sprintf(buf, "%03d", encCountsRight);
+      lcd.print(buf);
+    }
+    else
+    {
+      // Cycle the instructions every 2 seconds.
+      if (instructCount == 0)
+      {
+        lcd.print("Hold=run");
+      }
+      else if (instructCount == 40)
+      {
+        lcd.print("Tap=flip");
+      }
+      if (++instructCount == 80) { instructCount = 0; }
+    }
+
+    if (buttons.aIsPressed())
+    {
+      if (btnCountA < 4)
+      {
+        btnCountA++;
+      }
+      else
+      {
+        // Button has been held for more than 200 ms, so
+        // start running the motor.
+        leftSpeed += 15;
+      }
+    }
+    else
+    {
+      if (leftSpeed == 0 && btnCountA > 0 && btnCountA < 4)
+      {
+        // Motor isn't running and button was pressed for 200 ms
+        // or less, so turn the wheel once.
+        btnCountA = 0;
+        encCountsLeft = 0;
+        turning = TURN_LEFT;
+        output.setLeftEffort(50);
+        return true;
+      }
+      btnCountA = 0;
+      leftSpeed -= 30;
+    }
+
+    if (buttons.cIsPressed())
+    {
+      if (btnCountC < 4)
+      {
+        btnCountC++;
+      }
+      else
+      {
+        // Button has been held for more than 200 ms, so
+        // start running the motor.
+        rightSpeed += 15;
+      }
+    }
+    else
+    {
+      if (rightSpeed == 0 && btnCountC > 0 && btnCountC < 4)
+      {
+        btnCountC = 0;
+        encCountsRight = 0;
+        turning = TURN_RIGHT;
+        output.setRightEffort(50);
+        return true;
+      }
+      btnCountC = 0;
+      rightSpeed -= 30;
+    }
+
+    leftSpeed = constrain(leftSpeed, 0, 400);
+    rightSpeed = constrain(rightSpeed, 0, 400);
+
+    output.setEfforts(leftSpeed * leftDir, rightSpeed * rightDir);
+
+    lcd.gotoXY(1, 1);
+    lcd.print(btnCountA);
+    lcd.gotoXY(6, 1);
+    lcd.print(btnCountC);
+
+    // Display arrows pointing the appropriate direction
+    // (solid if the motor is running, chevrons if not).
+    lcd.gotoXY(0, 1);
+    if (leftSpeed == 0)
+    {
+      lcd.print((leftDir > 0) ? '\0' : '\1');
+    }
+    else
+    {
+      lcd.print((leftDir > 0) ? '\2' : '\3');
+    }
+    lcd.gotoXY(7, 1);
+    if (rightSpeed == 0)
+    {
+      lcd.print((rightDir > 0) ? '\0' : '\1');
+    }
+    else
+    {
+      lcd.print((rightDir > 0) ? '\2' : '\3');
+    }
+    return true;
+  }
+
+private:
+  enum Turn
+  {
+    TURN_NONE,
+    TURN_LEFT,
+    TURN_RIGHT
+  };
+
+  // Counts one wheel up to a revolution and then stops it.
+  bool turnStep(int16_t counts, int16_t countsPerRev)
+  {
+    char buf[7];
+    int16_t &total = turning == TURN_LEFT ? encCountsLeft : encCountsRight;
+    total += counts;
+
+    lcd.gotoXY(turning == TURN_LEFT ? 0 : 5, 0);
+    sprintf(buf, "%03d", total);
+    lcd.print(buf);
+
+    if (total >= countsPerRev)
+    {
+      if (turning == TURN_LEFT) { output.setLeftEffort(0); }
+      else { output.setRightEffort(0); }
+      turning = TURN_NONE;
+    }
+    return counts != 0;
+  }
+
+  Lcd &lcd;
+  Buttons &buttons;
+  Output &output;
+  bool showEncoders;
+
+  int16_t leftSpeed, rightSpeed;
+  int8_t leftDir, rightDir;
+  uint16_t lastUpdateTime;
+  uint8_t btnCountA, btnCountC, instructCount;
+  int16_t encCountsLeft, encCountsRight;
+  Turn turning;
+  JarEncoderSample lastEnc;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include <jarFixed.h>
+
+#ifndef FIXED_CPP
+#define FIXED_CPP
+
+// Quarter wave of sin() in Q1.15, one entry per 256th of a turn.
+static const int16_t sinTable[65] PROGMEM = {
+    0, 804, 1608, 2411, 3212, 4011, 4808, 5602,
+    6393, 7180, 7962, 8740, 9512, 10279, 11039, 11793,
+    12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+    18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+    23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791,
+    27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972,
+    32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+    32767,
+};
+
+// atan(i / 32) for i = 0..32, 65536 per turn.
+static const uint16_t atanTable[33] PROGMEM = {
+    0, 326, 651, 975, 1297, 1617, 1933, 2246,
+    2555, 2860, 3159, 3453, 3742, 4025, 4302, 4572,
+    4836, 5094, 5344, 5589, 5826, 6058, 6282, 6500,
+    6712, 6917, 7117, 7310, 7498, 7679, 7856, 8026,
+    8192,
+};
+
+int16_t JarFixed::sin8(uint8_t angle)
+{
+    uint8_t index = angle & 0x3f;
+    if (angle & 0x40)
+    {
+        index = 64 - index;
+    }
+    int16_t value = pgm_read_word(&sinTable[index]);
+    return (angle & 0x80) ? -value : value;
+}
+
+int16_t JarFixed::sin16(uint16_t angle)
+{
+    int16_t s0 = sin8(angle >> 8);
+    int16_t s1 = sin8((angle >> 8) + 1);
+    return s0 + (((int32_t)(s1 - s0) * (angle & 0xFF)) >> 8);
+}
+
+uint16_t JarFixed::atan2(int16_t y, int16_t x)
+{
+    if (x == 0 && y == 0)
+    {
+        return 0;
+    }
+
+    // Reduce to the first octant, where the ratio is 0..1.
+    uint16_t ax = x < 0 ? -(uint16_t)x : x;
+    uint16_t ay = y < 0 ? -(uint16_t)y : y;
+    bool steep = ay > ax;
+    uint16_t num = steep ? ax : ay;
+    uint16_t den = steep ? ay : ax;
+
+    // Ratio in 1/2048, then interpolate between table entries 1/32
+    // apart.
+    uint16_t ratio = ((uint32_t)num << 11) / den;
+    uint8_t index = ratio >> 6;
+    uint8_t frac = ratio & 63;
+    uint16_t angle = pgm_read_word(&atanTable[index]);
+    if (frac)
+    {
+        uint16_t next = pgm_read_word(&atanTable[index + 1]);
+        angle += ((next - angle) * frac + 32) >> 6;
+    }
+
+    if (steep)
+    {
+        angle = 16384 - angle;
+    }
+    if (x < 0)
+    {
+        angle = 32768 - angle;
+    }
+    if (y < 0)
+    {
+        angle = -angle;
+    }
+    return angle;
+}
+
+uint16_t JarFixed::sqrt(uint32_t x)
+{
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (x >= result + bit)
+        {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+uint16_t JarFixed::norm(int16_t x, int16_t y)
+{
+    return sqrt((uint32_t)mul16(x, x) + (uint32_t)mul16(y, y));
+}
+
+uint16_t JarFixed::norm(int16_t x, int16_t y, int16_t z)
+{
+    return sqrt((uint32_t)mul16(x, x) + (uint32_t)mul16(y, y) + (uint32_t)mul16(z, z));
+}
+
+#endif
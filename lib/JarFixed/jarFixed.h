@@ -0,0 +1,226 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <Arduino.h>
+
+// Fixed-point kernels for the ATmega32U4, which has no FPU.
+//
+// Q8.8 values are int16_t with 8 fraction bits, Q1.15 values are
+// int16_t with 15 fraction bits (-1 to just below 1). Angles are
+// uint8_t with 256 or uint16_t with 65536 steps per turn.
+class JarFixed
+{
+public:
+  // Signed 16 x 16 -> 32 bit multiply. On the AVR this uses the
+  // hardware multiplier inline instead of calling __mulhisi3.
+  static inline int32_t mul16(int16_t a, int16_t b)
+  {
+#if defined(__AVR_HAVE_MUL__)
+    int32_t result;
+    __asm__ __volatile__(
+        "clr r26 \n\t"
+        "mul %A1, %A2 \n\t"
+        "movw %A0, r0 \n\t"
+        "muls %B1, %B2 \n\t"
+        "movw %C0, r0 \n\t"
+        "mulsu %B2, %A1 \n\t"
+        "sbc %D0, r26 \n\t"
+        "add %B0, r0 \n\t"
+        "adc %C0, r1 \n\t"
+        "adc %D0, r26 \n\t"
+        "mulsu %B1, %A2 \n\t"
+        "sbc %D0, r26 \n\t"
+        "add %B0, r0 \n\t"
+        "adc %C0, r1 \n\t"
+        "adc %D0, r26 \n\t"
+        "clr r1 \n\t"
+        : "=&r"(result)
+        : "a"(a), "a"(b)
+        : "r26");
+    return result;
+#else
+    return (int32_t)a * b;
+#endif
+  }
+
+  static inline int16_t sat16(int32_t x)
+  {
+    if (x > 32767) { return 32767; }
+    if (x < -32768) { return -32768; }
+    return x;
+  }
+
+  static inline int16_t clamp(int16_t x, int16_t low, int16_t high)
+  {
+    if (x < low) { return low; }
+    if (x > high) { return high; }
+    return x;
+  }
+
+  // Saturating products, rounded to nearest (within half an LSB).
+  static inline int16_t mulQ8(int16_t a, int16_t b)
+  {
+    return sat16((mul16(a, b) + 0x80) >> 8);
+  }
+
+  static inline int16_t mulQ15(int16_t a, int16_t b)
+  {
+    return sat16((mul16(a, b) + 0x4000) >> 15);
+  }
+
+  // acc + a * b and acc - a * b, saturating at the int32_t limits.
+  static inline int32_t mac(int32_t acc, int16_t a, int16_t b)
+  {
+    int32_t p = mul16(a, b);
+    int32_t sum = (uint32_t)acc + (uint32_t)p;
+    if ((acc ^ p) >= 0 && (sum ^ acc) < 0)
+    {
+      return acc < 0 ? (-0x7FFFFFFFL - 1) : 0x7FFFFFFFL;
+    }
+    return sum;
+  }
+
+  static inline int32_t msc(int32_t acc, int16_t a, int16_t b)
+  {
+    int32_t p = mul16(a, b);
+    int32_t diff = (uint32_t)acc - (uint32_t)p;
+    if ((acc ^ p) < 0 && (diff ^ acc) < 0)
+    {
+      return acc < 0 ? (-0x7FFFFFFFL - 1) : 0x7FFFFFFFL;
+    }
+    return diff;
+  }
+
+  // Sine and cosine in Q1.15 from a quarter-wave table; the 16-bit
+  // versions interpolate linearly between table entries. The 8-bit
+  // versions are within 1 LSB, the 16-bit ones within 4 LSB.
+  static int16_t sin8(uint8_t angle);
+  static int16_t cos8(uint8_t angle) { return sin8(angle + 64); }
+  static int16_t sin16(uint16_t angle);
+  static int16_t cos16(uint16_t angle) { return sin16(angle + 16384); }
+
+  // Angle of the vector (x, y), 65536 per turn, counterclockwise
+  // from the x axis. Accurate to about 0.04 degrees.
+  static uint16_t atan2(int16_t y, int16_t x);
+
+  // Integer square root, rounded down. Exact, as are the norms.
+  static uint16_t sqrt(uint32_t x);
+
+  static uint16_t norm(int16_t x, int16_t y);
+  static uint16_t norm(int16_t x, int16_t y, int16_t z);
+};
+
+// First-order low-pass filter, y += (x - y) / 2^shift. The state has
+// 8 extra fraction bits so small steps are not lost; the output is
+// within 1 LSB of the same filter in float.
+class JarLowPass
+{
+public:
+  explicit JarLowPass(uint8_t shift) : shift(shift), state(0) {}
+
+  void reset(int16_t value) { state = (int32_t)value * 256; }
+
+  int16_t update(int16_t x)
+  {
+    state += ((int32_t)x * 256 - state) >> shift;
+    return (state + 0x80) >> 8;
+  }
+
+  int16_t value() const { return (state + 0x80) >> 8; }
+
+private:
+  uint8_t shift;
+  int32_t state;
+};
+
+// Direct form I biquad. Coefficients are Q2.14 (-2 to just below 2)
+// with a0 = 1 and the feedback terms given with the sign they have
+// in the denominator: y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2.
+// Rounding the coefficients and the fed-back outputs costs a few LSB
+// against a float filter; about 2 for a low-pass at a tenth of the
+// sample rate.
+class JarBiquad
+{
+public:
+  JarBiquad(int16_t b0, int16_t b1, int16_t b2, int16_t a1, int16_t a2)
+    : b0(b0), b1(b1), b2(b2), a1(a1), a2(a2)
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    x1 = x2 = y1 = y2 = 0;
+  }
+
+  int16_t update(int16_t x)
+  {
+    int32_t acc = 1L << 13;
+    acc = JarFixed::mac(acc, b0, x);
+    acc = JarFixed::mac(acc, b1, x1);
+    acc = JarFixed::mac(acc, b2, x2);
+    acc = JarFixed::msc(acc, a1, y1);
+    acc = JarFixed::msc(acc, a2, y2);
+    int16_t y = JarFixed::sat16(acc >> 14);
+
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    return y;
+  }
+
+private:
+  int16_t b0, b1, b2, a1, a2;
+  int16_t x1, x2, y1, y2;
+};
+
+// Mean of the last N samples, N a power of two, kept as a running
+// sum so each update is O(1). The sum is exact, so the mean is off
+// by the rounding only.
+template <uint8_t N>
+class JarMovingAverage
+{
+public:
+  JarMovingAverage()
+  {
+    static_assert((N & (N - 1)) == 0, "N must be a power of two");
+    reset(0);
+  }
+
+  void reset(int16_t value)
+  {
+    for (uint8_t i = 0; i < N; i++)
+    {
+      samples[i] = value;
+    }
+    sum = (int32_t)value * N;
+    index = 0;
+  }
+
+  int16_t update(int16_t x)
+  {
+    sum += (int32_t)x - samples[index];
+    samples[index] = x;
+    index = (index + 1) & (N - 1);
+    return value();
+  }
+
+  // Rounded to nearest; a shift is cheaper than a signed division
+  // on the AVR.
+  int16_t value() const { return (sum + N / 2) >> shift(); }
+
+private:
+  static uint8_t shift()
+  {
+    uint8_t s = 0;
+    while ((1 << s) < N) { s++; }
+    return s;
+  }
+
+  int16_t samples[N];
+  int32_t sum;
+  uint8_t index;
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include <jarLineFast.h>
+
+#ifndef LINE_FAST_CPP
+#define LINE_FAST_CPP
+
+// Time the IR emitters need to turn fully on or off.
+#define LINE_FAST_EMITTER_SETTLE_US 200
+
+JarLineFast::JarLineFast()
+{
+    for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+    {
+        timeouts[i] = LINE_FAST_FULL_TIMEOUT;
+        thresholds[i] = LINE_FAST_FULL_TIMEOUT;
+        on[i] = off[i] = LINE_FAST_FULL_TIMEOUT;
+    }
+    dark = 0;
+    slotOn = false;
+    emitterMode = emitterOutput = 0;
+    emitterMask = 0;
+    samples = rate = 0;
+    rateStart = 0;
+    sinceCheck = 0;
+    resetStats();
+}
+
+void JarLineFast::begin(const uint8_t pins[LINE_FAST_SENSORS], uint8_t emitterPin)
+{
+    // Look the registers up once so the timing loop only does
+    // direct port accesses.
+    for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+    {
+        uint8_t port = digitalPinToPort(pins[i]);
+        inputs[i] = portInputRegister(port);
+        modes[i] = portModeRegister(port);
+        outputs[i] = portOutputRegister(port);
+        masks[i] = digitalPinToBitMask(pins[i]);
+    }
+    uint8_t port = digitalPinToPort(emitterPin);
+    emitterMode = portModeRegister(port);
+    emitterOutput = portOutputRegister(port);
+    emitterMask = digitalPinToBitMask(emitterPin);
+    rateStart = millis();
+}
+
+void JarLineFast::setCalibration(const uint16_t minimum[LINE_FAST_SENSORS],
+                                 const uint16_t maximum[LINE_FAST_SENSORS])
+{
+    for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+    {
+        // Leave some room above the calibrated maximum.
+        uint32_t timeout = (uint32_t)maximum[i] * 9 / 8;
+        timeouts[i] = min(timeout, (uint32_t)LINE_FAST_FULL_TIMEOUT);
+        thresholds[i] = (minimum[i] + maximum[i]) / 2;
+    }
+}
+
+void JarLineFast::resetStats()
+{
+    errorSum = 0;
+    checks = 0;
+    decisionErrors = 0;
+}
+
+// The emitter pin is shared with the QTR driver, which switches it
+// too, so the pin itself is checked rather than a cached state. The
+// settle delay is only paid when the emitters actually change.
+void JarLineFast::emitters(bool on)
+{
+    bool driven = *emitterMode & emitterMask;
+    bool high = *emitterOutput & emitterMask;
+    if (driven && high == on)
+    {
+        return;
+    }
+    uint8_t sreg = SREG;
+    noInterrupts();
+    if (on) { *emitterOutput |= emitterMask; }
+    else { *emitterOutput &= ~emitterMask; }
+    *emitterMode |= emitterMask;
+    SREG = sreg;
+    delayMicroseconds(LINE_FAST_EMITTER_SETTLE_US);
+}
+
+// Charges the sensor capacitors and times how long each takes to
+// discharge, giving up on a sensor when it reaches its limit. The
+// read ends when the last sensor is done.
+void JarLineFast::measure(uint16_t values[LINE_FAST_SENSORS], const uint16_t limits[LINE_FAST_SENSORS])
+{
+    for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+    {
+        *outputs[i] |= masks[i];
+        *modes[i] |= masks[i];
+    }
+    delayMicroseconds(10);
+
+    uint8_t sreg = SREG;
+    noInterrupts();
+    for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+    {
+        *modes[i] &= ~masks[i];
+        *outputs[i] &= ~masks[i];
+    }
+    SREG = sreg;
+
+    uint16_t start = micros();
+    uint8_t remaining = (1 << LINE_FAST_SENSORS) - 1;
+    while (remaining)
+    {
+        uint16_t elapsed = micros() - start;
+        for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+        {
+            if (!(remaining & (1 << i)))
+            {
+                continue;
+            }
+            if (!(*inputs[i] & masks[i]))
+            {
+                values[i] = min(elapsed, limits[i]);
+                remaining &= ~(1 << i);
+            }
+            else if (elapsed >= limits[i])
+            {
+                values[i] = limits[i];
+                remaining &= ~(1 << i);
+            }
+        }
+    }
+}
+
+uint8_t JarLineFast::read(uint16_t values[LINE_FAST_SENSORS], bool emittersOn, bool decide)
+{
+    emitters(emittersOn);
+    measure(values, decide ? thresholds : timeouts);
+
+    uint8_t darkMask = 0;
+    for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+    {
+        if (values[i] >= thresholds[i])
+        {
+            darkMask |= 1 << i;
+        }
+    }
+
+    count();
+    if (++sinceCheck >= LINE_FAST_CHECK_EVERY)
+    {
+        sinceCheck = 0;
+        check(values, darkMask, emittersOn);
+    }
+    return darkMask;
+}
+
+bool JarLineFast::readAlternating()
+{
+    slotOn = !slotOn;
+    if (slotOn)
+    {
+        dark = read(on, true, true);
+    }
+    else
+    {
+        read(off, false, false);
+    }
+    return slotOn;
+}
+
+void JarLineFast::count()
+{
+    samples++;
+    uint16_t now = millis();
+    if ((uint16_t)(now - rateStart) >= 1000)
+    {
+        rate = samples;
+        samples = 0;
+        rateStart = now;
+    }
+}
+
+// Makes a full read right after a fast one and compares them. Values
+// a fast read cut short are compared as if the full read had been
+// cut at the same point.
+void JarLineFast::check(const uint16_t values[LINE_FAST_SENSORS], uint8_t darkMask, bool emittersOn)
+{
+    static const uint16_t fullLimits[LINE_FAST_SENSORS] = {
+        LINE_FAST_FULL_TIMEOUT, LINE_FAST_FULL_TIMEOUT, LINE_FAST_FULL_TIMEOUT};
+    uint16_t full[LINE_FAST_SENSORS];
+
+    emitters(emittersOn);
+    measure(full, fullLimits);
+
+    for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+    {
+        uint16_t reference = full[i];
+        if (values[i] == thresholds[i] || values[i] == timeouts[i])
+        {
+            reference = min(reference, values[i]);
+        }
+        errorSum += abs((int32_t)reference - values[i]);
+
+        bool fullDark = full[i] >= thresholds[i];
+        if (fullDark != (bool)(darkMask & (1 << i)))
+        {
+            decisionErrors++;
+        }
+    }
+    checks += LINE_FAST_SENSORS;
+}
+
+#endif
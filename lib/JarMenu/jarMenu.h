@@ -1,16 +1,86 @@
+#ifndef MENU_H
+#define MENU_H
+
+#include <Arduino.h>
 #include <jarMenuItem.h>
 
+// A menu on the 8x2 LCD that is scrolled with the A and C buttons
+// and selected with B. Lcd is e.g. Zumo32U4LCD, Buttons a JarButton.
+template <class Lcd, class Buttons>
 class JarMenu
 {
 public:
-  JarMenu(JarMenuItem *items, uint8_t itemCount, Zumo32U4LCD *lcd);
-  void lcdUpdate(uint8_t index);
-  void action(uint8_t index);
-  void select();
+  JarMenu(JarMenuItem *items, uint8_t itemCount, Lcd &lcd, Buttons &buttons)
+    : items(items), itemCount(itemCount), lcdItemIndex(0),
+      lcdRef(lcd), buttonsRef(buttons)
+  {
+  }
+
+  void lcdUpdate(uint8_t index)
+  {
+    lcdRef.clear();
+    lcdRef.print(items[index].name);
+    lcdRef.gotoXY(0, 1);
+    lcdRef.print(F("\x7f"
+                   "A \xa5"
+                   "B C\x7e"));
+  }
+
+  void action(uint8_t index)
+  {
+    items[index].action();
+  }
+
+  // Prompts the user to choose one of the menu items,
+  // then runs it, then returns.
+  void select()
+  {
+    lcdUpdate(lcdItemIndex);
+
+    while (1)
+    {
+      switch (buttonsRef.monitor())
+      {
+      case 'A':
+        // The A button was pressed so decrement the index.
+        if (lcdItemIndex == 0)
+        {
+          lcdItemIndex = itemCount - 1;
+        }
+        else
+        {
+          lcdItemIndex--;
+        }
+        lcdUpdate(lcdItemIndex);
+        break;
+
+      case 'C':
+        // The C button was pressed so increase the index.
+        if (lcdItemIndex >= itemCount - 1)
+        {
+          lcdItemIndex = 0;
+        }
+        else
+        {
+          lcdItemIndex++;
+        }
+        lcdUpdate(lcdItemIndex);
+        break;
+
+      case 'B':
+        // The B button was pressed so run the item and return.
+        action(lcdItemIndex);
+        return;
+      }
+    }
+  }
 
 private:
   JarMenuItem *items;
   uint8_t itemCount;
   uint8_t lcdItemIndex;
-  Zumo32U4LCD *lcdRef;
+  Lcd &lcdRef;
+  Buttons &buttonsRef;
 };
+
+#endif
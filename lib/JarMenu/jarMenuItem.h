@@ -1,5 +1,12 @@
+#ifndef MENU_ITEM_H
+#define MENU_ITEM_H
+
+#include <Arduino.h>
+
 struct JarMenuItem
 {
-    const char *name;
+    const __FlashStringHelper *name;
     void (*action)();
 };
+
+#endif
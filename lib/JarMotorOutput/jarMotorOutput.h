@@ -0,0 +1,106 @@
+#ifndef MOTOR_OUTPUT_H
+#define MOTOR_OUTPUT_H
+
+#include <Arduino.h>
+
+#define MOTOR_OUTPUT_MAX 400
+
+// Motor output stage that keeps a commanded effort independent of
+// the battery voltage and limits the motor current.
+//
+// An effort of -400..400 means the wheel voltage that PWM value
+// gives at the nominal battery voltage; it is scaled up as the
+// battery drains. The current through a motor is
+// (applied voltage - back EMF) / winding resistance, with the back
+// EMF proportional to the wheel speed, so the applied voltage is
+// kept within currentLimit * resistance of the back EMF. That keeps
+// stalls and hard reversals from pulling VIN down into a brownout.
+// An effort of 0 always turns the output off, so stopping does not
+// keep driving the motor at its back EMF.
+//
+// Motors is e.g. Zumo32U4Motors.
+template <class Motors>
+class JarMotorOutput
+{
+public:
+  explicit JarMotorOutput(Motors &motors)
+    : motors(motors), batteryMv(0), nominalMv(5000), maxDropMv(0x7FFF),
+      bemfUvPerCps(0), halted(false)
+  {
+    efforts[0] = efforts[1] = 0;
+    speeds[0] = speeds[1] = 0;
+  }
+
+  // bemfUvPerCps is the back EMF in microvolts per encoder count
+  // per second.
+  void setLimits(uint16_t nominalMv, uint16_t currentLimitMa,
+                 uint16_t resistanceMohm, uint16_t bemfUvPerCps)
+  {
+    this->nominalMv = nominalMv;
+    this->maxDropMv = min((uint32_t)currentLimitMa * resistanceMohm / 1000, (uint32_t)0x7FFF);
+    this->bemfUvPerCps = bemfUvPerCps;
+  }
+
+  // Latest battery voltage and wheel speeds in encoder counts per
+  // second; call update() afterwards to apply them.
+  void setBattery(uint16_t millivolts) { batteryMv = millivolts; }
+  void setSpeeds(int16_t leftCps, int16_t rightCps)
+  {
+    speeds[0] = leftCps;
+    speeds[1] = rightCps;
+  }
+
+  void setEfforts(int16_t left, int16_t right)
+  {
+    efforts[0] = left;
+    efforts[1] = right;
+    update();
+  }
+  void setLeftEffort(int16_t left) { setEfforts(left, efforts[1]); }
+  void setRightEffort(int16_t right) { setEfforts(efforts[0], right); }
+
+  // Recomputes the PWM values for the current battery voltage and
+  // speeds.
+  void update()
+  {
+    if (halted) { return; }
+    motors.setSpeeds(toPwm(efforts[0], speeds[0]), toPwm(efforts[1], speeds[1]));
+  }
+
+  // Stops the motors and ignores further commands until resume().
+  // Safe to call from an interrupt.
+  void stop()
+  {
+    halted = true;
+    efforts[0] = efforts[1] = 0;
+    motors.setSpeeds(0, 0);
+  }
+
+  void resume() { halted = false; }
+
+  // The PWM value an effort gives at the given wheel speed.
+  int16_t toPwm(int16_t effort, int16_t cps) const
+  {
+    if (effort == 0) { return 0; }
+
+    uint16_t battery = batteryMv ? batteryMv : nominalMv;
+    int32_t targetMv = (int32_t)effort * nominalMv / MOTOR_OUTPUT_MAX;
+    int32_t bemfMv = (int32_t)cps * bemfUvPerCps / 1000;
+    targetMv = constrain(targetMv, bemfMv - maxDropMv, bemfMv + maxDropMv);
+
+    int32_t pwm = targetMv * MOTOR_OUTPUT_MAX / battery;
+    return constrain(pwm, -MOTOR_OUTPUT_MAX, MOTOR_OUTPUT_MAX);
+  }
+
+private:
+  Motors &motors;
+  uint16_t batteryMv;
+  uint16_t nominalMv;
+  int16_t maxDropMv;
+  uint16_t bemfUvPerCps;
+  volatile bool halted;
+  volatile int16_t efforts[2];
+  int16_t speeds[2];
+};
+
+#endif
@@ -0,0 +1,242 @@
+#include <jarOccupancy.h>
+
+#ifndef OCCUPANCY_CPP
+#define OCCUPANCY_CPP
+
+// Bearings of the six proximity channels relative to the heading,
+// in 256ths of a turn, in the order passed to updateProx().
+static const int8_t proxBearings[6] = {64, 32, 11, -11, -32, -64};
+
+// Steps through the grid cells on the line between two cells
+// (Bresenham), starting at the first one.
+class OccRay
+{
+public:
+    OccRay(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+    {
+        x = x0;
+        y = y0;
+        dx = abs(x1 - x0);
+        dy = -abs(y1 - y0);
+        sx = (x0 < x1) ? 1 : -1;
+        sy = (y0 < y1) ? 1 : -1;
+        err = dx + dy;
+        steps = max(dx, (int16_t)-dy);
+    }
+
+    void next()
+    {
+        int16_t e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y += sy;
+        }
+    }
+
+    bool inGrid() const
+    {
+        return x >= 0 && x < OCC_GRID_SIZE && y >= 0 && y < OCC_GRID_SIZE;
+    }
+
+    // True if the ray steps along x more than along y.
+    bool xMajor() const
+    {
+        return dx >= -dy;
+    }
+
+    int16_t x, y;
+    int16_t steps;
+
+private:
+    int16_t dx, dy, sx, sy, err;
+};
+
+// Converts a world coordinate in 1/256 mm to a cell index, which may
+// lie outside of the grid. Coordinates far outside are clamped so the
+// division can be done in 16 bits.
+static int16_t toCell(int32_t q8)
+{
+    int32_t mm = (q8 >> 8) + (int32_t)OCC_GRID_SIZE * OCC_CELL_MM / 2;
+    int16_t clamped = constrain(mm, -30000L, 30000L);
+    if (clamped < 0)
+    {
+        return -1 - (-1 - clamped) / OCC_CELL_MM;
+    }
+    return clamped / OCC_CELL_MM;
+}
+
+// Returns the end point of a ray of the given length, in 1/256 mm.
+static void rayEnd(const JarPose &pose, uint8_t bearing, uint16_t rangeMm,
+                   int32_t *x, int32_t *y)
+{
+    uint8_t angle = (pose.heading >> 8) + bearing;
+    *x = pose.x + (((int32_t)rangeMm * JarFixed::cos8(angle)) >> 7);
+    *y = pose.y + (((int32_t)rangeMm * JarFixed::sin8(angle)) >> 7);
+}
+
+JarOdometry::JarOdometry()
+{
+    reset();
+}
+
+void JarOdometry::reset()
+{
+    current.x = 0;
+    current.y = 0;
+    current.heading = 0;
+}
+
+void JarOdometry::update(int16_t countsLeft, int16_t countsRight)
+{
+    // Use the heading halfway through the move for the position update.
+    int16_t turn = ((int32_t)(countsRight - countsLeft) * ODO_HEADING_PER_COUNT_Q8) >> 8;
+    uint8_t angle = (current.heading + turn / 2) >> 8;
+    int32_t distance = ((int32_t)(countsLeft + countsRight) * ODO_MM_PER_COUNT_Q8) / 2;
+
+    // Halve the sine first so a long move cannot overflow 32 bits.
+    current.x += (distance * (JarFixed::cos8(angle) >> 1)) >> 14;
+    current.y += (distance * (JarFixed::sin8(angle) >> 1)) >> 14;
+    current.heading += turn;
+}
+
+JarOccupancy::JarOccupancy()
+{
+    clear();
+}
+
+void JarOccupancy::clear()
+{
+    memset(cells, 0, sizeof(cells));
+}
+
+uint8_t JarOccupancy::get(uint8_t cx, uint8_t cy) const
+{
+    uint16_t i = ((uint16_t)cy << OCC_GRID_BITS) | cx;
+    return (cells[i >> 2] >> ((i & 3) * 2)) & OCC_CELL_MAX;
+}
+
+void JarOccupancy::set(uint8_t cx, uint8_t cy, uint8_t value)
+{
+    uint16_t i = ((uint16_t)cy << OCC_GRID_BITS) | cx;
+    uint8_t shift = (i & 3) * 2;
+    cells[i >> 2] = (cells[i >> 2] & ~(OCC_CELL_MAX << shift)) | (value << shift);
+}
+
+void JarOccupancy::raise(uint8_t cx, uint8_t cy, uint8_t amount)
+{
+    uint8_t value = get(cx, cy) + amount;
+    set(cx, cy, min(value, (uint8_t)OCC_CELL_MAX));
+}
+
+void JarOccupancy::lower(uint8_t cx, uint8_t cy)
+{
+    uint8_t value = get(cx, cy);
+    if (value > 0)
+    {
+        set(cx, cy, value - 1);
+    }
+}
+
+// Clears the cells along a ray and, if hit is set, marks the cell at
+// its end as occupied. The robot's own cell is left alone: it cannot
+// be seen as free, and a hit there would be cleared again by the rays
+// of the other channels.
+void JarOccupancy::ray(const JarPose &pose, uint8_t bearing, uint16_t rangeMm, bool hit)
+{
+    if (hit)
+    {
+        rangeMm = max(rangeMm, (uint16_t)OCC_MIN_HIT_MM);
+    }
+
+    int32_t ex, ey;
+    rayEnd(pose, bearing, rangeMm, &ex, &ey);
+    OccRay r(toCell(pose.x), toCell(pose.y), toCell(ex), toCell(ey));
+
+    for (int16_t i = 0; i <= r.steps; i++, r.next())
+    {
+        if (i == 0 || !r.inGrid())
+        {
+            continue;
+        }
+        if (i == r.steps && hit)
+        {
+            raise(r.x, r.y, 2);
+        }
+        else
+        {
+            lower(r.x, r.y);
+        }
+    }
+}
+
+// Feeds one set of proximity readings into the grid. The counts are
+// in the order left/left LEDs, left/right LEDs, front/left LEDs,
+// front/right LEDs, right/left LEDs, right/right LEDs. A higher count
+// means a closer obstacle; zero means nothing in range. The free rays
+// go first, so they cannot clear what the hits of this same update
+// marked.
+void JarOccupancy::updateProx(const JarPose &pose, const uint8_t counts[6])
+{
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (counts[i] == 0)
+        {
+            ray(pose, proxBearings[i], OCC_PROX_RANGE_MM, false);
+        }
+    }
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (counts[i] != 0)
+        {
+            uint8_t c = min(counts[i], (uint8_t)6);
+            uint16_t range = OCC_PROX_RANGE_MM - c * (OCC_PROX_RANGE_MM / 7);
+            ray(pose, proxBearings[i], range, true);
+        }
+    }
+}
+
+// Lowers every occupied cell by one, four cells per byte at a time.
+void JarOccupancy::decay()
+{
+    for (uint16_t i = 0; i < sizeof(cells); i++)
+    {
+        uint8_t b = cells[i];
+        cells[i] = b - ((b | (b >> 1)) & 0x55);
+    }
+}
+
+// Returns the distance in mm to the first occupied cell in the given
+// direction, or 0xFFFF if there is none within maxMm. The search
+// covers a corridor three cells wide, about the width of the robot,
+// so obstacles marked by the slanted front channels are not missed.
+uint16_t JarOccupancy::nearest(const JarPose &pose, uint8_t bearing, uint16_t maxMm) const
+{
+    int32_t ex, ey;
+    rayEnd(pose, bearing, maxMm, &ex, &ey);
+    OccRay r(toCell(pose.x), toCell(pose.y), toCell(ex), toCell(ey));
+    int8_t sideX = r.xMajor() ? 0 : 1;
+    int8_t sideY = r.xMajor() ? 1 : 0;
+
+    for (int16_t i = 0; i <= r.steps; i++, r.next())
+    {
+        for (int8_t side = -1; side <= 1; side++)
+        {
+            int16_t x = r.x + side * sideX;
+            int16_t y = r.y + side * sideY;
+            if (x >= 0 && x < OCC_GRID_SIZE && y >= 0 && y < OCC_GRID_SIZE &&
+                get(x, y) >= OCC_HIT_LEVEL)
+            {
+                return r.steps ? (uint32_t)maxMm * i / r.steps : 0;
+            }
+        }
+    }
+    return 0xFFFF;
+}
+
+#endif
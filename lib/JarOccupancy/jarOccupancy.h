@@ -0,0 +1,74 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <Arduino.h>
+#include <jarFixed.h>
+
+// The grid is fixed in the world frame and centered on the position
+// where the odometry was last reset. 32 x 32 cells of 50 mm cover
+// 1.6 m x 1.6 m; with 2 bits per cell the whole grid takes 256 bytes.
+#define OCC_GRID_BITS 5
+#define OCC_GRID_SIZE (1 << OCC_GRID_BITS)
+#define OCC_CELL_MM 50
+#define OCC_CELL_MAX 3
+
+// A cell at or above this value counts as an obstacle.
+#define OCC_HIT_LEVEL 2
+
+// Farthest distance the proximity sensors can see an obstacle.
+#define OCC_PROX_RANGE_MM 300
+
+// Hits are placed at least this far out, so they always land outside
+// the robot's own cell.
+#define OCC_MIN_HIT_MM (OCC_CELL_MM * 3 / 2)
+
+// Odometry constants for the Zumo 32U4 with 75:1 gearmotors:
+// millimeters per encoder count and heading units (65536 per turn)
+// per count of difference between the wheels, both times 256.
+#define ODO_MM_PER_COUNT_Q8 34
+#define ODO_HEADING_PER_COUNT_Q8 3669
+
+// Robot pose. x and y are in 1/256 mm, heading is 65536 per turn
+// (counterclockwise, 0 = along the x axis).
+struct JarPose
+{
+  int32_t x;
+  int32_t y;
+  uint16_t heading;
+};
+
+// Dead reckoning from encoder count deltas.
+class JarOdometry
+{
+public:
+  JarOdometry();
+  void reset();
+  void update(int16_t countsLeft, int16_t countsRight);
+  const JarPose &pose() const { return current; }
+
+private:
+  JarPose current;
+};
+
+// Occupancy grid filled from the six proximity count channels
+// (left/front/right sensor with left/right LEDs).
+class JarOccupancy
+{
+public:
+  JarOccupancy();
+  void clear();
+  uint8_t get(uint8_t cx, uint8_t cy) const;
+  void updateProx(const JarPose &pose, const uint8_t counts[6]);
+  void ray(const JarPose &pose, uint8_t bearing, uint16_t rangeMm, bool hit);
+  void decay();
+  uint16_t nearest(const JarPose &pose, uint8_t bearing, uint16_t maxMm) const;
+
+private:
+  void set(uint8_t cx, uint8_t cy, uint8_t value);
+  void raise(uint8_t cx, uint8_t cy, uint8_t amount);
+  void lower(uint8_t cx, uint8_t cy);
+
+  uint8_t cells[OCC_GRID_SIZE * OCC_GRID_SIZE / 4];
+};
+
+#endif
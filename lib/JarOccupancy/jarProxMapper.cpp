@@ -0,0 +1,58 @@
+#include <jarProxMapper.h>
+
+#ifndef PROX_MAPPER_CPP
+#define PROX_MAPPER_CPP
+
+JarProxMapper::JarProxMapper(JarOdometry &odometry, JarOccupancy &grid)
+    : odometry(odometry), grid(grid)
+{
+    memset(&lastEncoders, 0, sizeof(lastEncoders));
+    lastProxSeq = 0;
+    lastDecayTime = 0;
+}
+
+void JarProxMapper::begin(const JarBus &bus, uint16_t now)
+{
+    odometry.reset();
+    grid.clear();
+    if (!bus.encoders.read(lastEncoders))
+    {
+        memset(&lastEncoders, 0, sizeof(lastEncoders));
+    }
+    lastProxSeq = bus.prox.sequence();
+    lastDecayTime = now;
+}
+
+bool JarProxMapper::update(const JarBus &bus, uint16_t now)
+{
+    JarEncoderSample encoders;
+    if (bus.encoders.read(encoders))
+    {
+        odometry.update(encoders.left - lastEncoders.left, encoders.right - lastEncoders.right);
+        lastEncoders = encoders;
+    }
+
+    // Forget obstacles that have not been seen for a while.
+    if ((uint16_t)(now - lastDecayTime) >= OCC_DECAY_PERIOD_MS)
+    {
+        lastDecayTime = now;
+        grid.decay();
+    }
+
+    // Only new proximity readings go into the grid.
+    JarProxSample prox;
+    if (bus.prox.sequence() == lastProxSeq || !bus.prox.read(prox))
+    {
+        return false;
+    }
+    lastProxSeq = bus.prox.sequence();
+    grid.updateProx(odometry.pose(), prox.counts);
+    return true;
+}
+
+uint16_t JarProxMapper::ahead() const
+{
+    return grid.nearest(odometry.pose(), 0, OCC_PROX_RANGE_MM);
+}
+
+#endif
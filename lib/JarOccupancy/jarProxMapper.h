@@ -0,0 +1,38 @@
+#ifndef PROX_MAPPER_H
+#define PROX_MAPPER_H
+
+#include <Arduino.h>
+#include <jarBus.h>
+#include <jarOccupancy.h>
+
+// How often JarProxMapper lets the grid forget old obstacles.
+#define OCC_DECAY_PERIOD_MS 1000
+
+// Builds a grid from the encoder and proximity samples on the bus:
+// the pose follows the encoders, every new proximity sample goes into
+// the grid and old obstacles decay once a period.
+class JarProxMapper
+{
+public:
+  JarProxMapper(JarOdometry &odometry, JarOccupancy &grid);
+
+  // Clears the grid and the pose and starts from the samples on the
+  // bus now.
+  void begin(const JarBus &bus, uint16_t now);
+
+  // Catches up with the bus. Returns true if a new proximity sample
+  // went into the grid.
+  bool update(const JarBus &bus, uint16_t now);
+
+  // Distance to the nearest obstacle straight ahead, or 0xFFFF.
+  uint16_t ahead() const;
+
+private:
+  JarOdometry &odometry;
+  JarOccupancy &grid;
+  JarEncoderSample lastEncoders;
+  uint8_t lastProxSeq;
+  uint16_t lastDecayTime;
+};
+
+#endif
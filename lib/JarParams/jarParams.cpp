@@ -0,0 +1,189 @@
+#include <jarParams.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#ifndef PARAMS_CPP
+#define PARAMS_CPP
+
+// AccThr is in accelerometer counts at the +/-4 g full scale that
+// JarCollision sets up (0.122 mg per count).
+static const JarParamInfo paramInfo[PARAM_COUNT] PROGMEM = {
+    {"GyroThr", 0, 32000, 2000, 100},
+    {"AccThr", 0, 8000, 100, 25},
+    {"CntRev", 100, 2000, 900, 10},
+    {"MotorMs", 10, 500, 50, 5},
+    {"ShowMs", 50, 2000, 250, 50},
+    {"LnMin0", 0, 2000, 0, 10},
+    {"LnMin1", 0, 2000, 0, 10},
+    {"LnMin2", 0, 2000, 0, 10},
+    {"LnMax0", 0, 2000, 2000, 10},
+    {"LnMax1", 0, 2000, 2000, 10},
+    {"LnMax2", 0, 2000, 2000, 10},
+    {"GyroBias", -2000, 2000, 0, 1},
+    {"Calib", 0, 1, 0, 1},
+    {"MotorKp", 0, 32767, 256, 16},
+    {"MotorKi", 0, 32767, 0, 4},
+    {"MotorKd", 0, 32767, 0, 4},
+    {"ClickMg", 31, 3937, 500, 31},
+    {"ImpactMg", 31, 3937, 1500, 31},
+    {"NomMv", 3000, 7000, 5000, 100},
+    {"MaxMa", 100, 3000, 1200, 50},
+    {"MotMohm", 500, 20000, 3750, 50},
+    {"BemfUv", 0, 2000, 633, 10},
+    {"TuneSet", 1, 200, 18, 1},
+    {"TuneBias", 0, 400, 150, 10},
+    {"TuneRly", 10, 400, 60, 10},
+    {"TuneHys", 0, 20, 1, 1},
+};
+
+JarParams::JarParams()
+{
+    lineLength = 0;
+    setDefaults();
+}
+
+void JarParams::info(JarParamId id, JarParamInfo *info)
+{
+    memcpy_P(info, &paramInfo[id], sizeof(JarParamInfo));
+}
+
+void JarParams::setDefaults()
+{
+    image.version = PARAMS_VERSION;
+    image.count = PARAM_COUNT;
+    for (uint8_t i = 0; i < PARAM_COUNT; i++)
+    {
+        image.values[i] = pgm_read_word(&paramInfo[i].def);
+    }
+}
+
+uint16_t JarParams::crc(const JarParamImage &image)
+{
+    const uint8_t *bytes = (const uint8_t *)&image;
+    uint16_t result = 0xFFFF;
+    for (uint8_t i = 0; i < offsetof(JarParamImage, crc); i++)
+    {
+        result = _crc16_update(result, bytes[i]);
+    }
+    return result;
+}
+
+bool JarParams::load()
+{
+    JarParamImage stored;
+    eeprom_read_block(&stored, (const void *)PARAMS_EEPROM_ADDRESS, sizeof(stored));
+
+    if (stored.version != PARAMS_VERSION || stored.count != PARAM_COUNT ||
+        stored.crc != crc(stored))
+    {
+        setDefaults();
+        return false;
+    }
+
+    image = stored;
+    return true;
+}
+
+// Only bytes that changed are written, so saving an unchanged image
+// does not wear the EEPROM.
+void JarParams::save()
+{
+    image.crc = crc(image);
+    eeprom_update_block(&image, (void *)PARAMS_EEPROM_ADDRESS, sizeof(image));
+}
+
+// Clamped in 32 bits, so a value beyond int16_t lands on a limit
+// instead of wrapping around to the other end.
+void JarParams::set(JarParamId id, int32_t value)
+{
+    int16_t low = pgm_read_word(&paramInfo[id].min);
+    int16_t high = pgm_read_word(&paramInfo[id].max);
+    image.values[id] = constrain(value, (int32_t)low, (int32_t)high);
+}
+
+void JarParams::step(JarParamId id, int8_t direction)
+{
+    int16_t size = pgm_read_word(&paramInfo[id].step);
+    set(id, (int32_t)image.values[id] + (int32_t)direction * size);
+}
+
+int8_t JarParams::find(const char *name)
+{
+    for (uint8_t i = 0; i < PARAM_COUNT; i++)
+    {
+        if (strcasecmp_P(name, paramInfo[i].name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void JarParams::print(Stream &stream, JarParamId id)
+{
+    stream.print((const __FlashStringHelper *)paramInfo[id].name);
+    stream.print('=');
+    stream.println(image.values[id]);
+}
+
+void JarParams::poll(Stream &stream)
+{
+    while (stream.available())
+    {
+        char c = stream.read();
+        if (c == '\r' || c == '\n')
+        {
+            line[lineLength] = 0;
+            if (lineLength > 0)
+            {
+                command(stream);
+            }
+            lineLength = 0;
+        }
+        else if (lineLength < sizeof(line) - 1)
+        {
+            line[lineLength++] = c;
+        }
+    }
+}
+
+void JarParams::command(Stream &stream)
+{
+    char *verb = strtok(line, " ");
+    char *name = strtok(NULL, " ");
+    char *value = strtok(NULL, " ");
+    int8_t id = name ? find(name) : -1;
+
+    if (!verb)
+    {
+        return;
+    }
+
+    if (strcmp_P(verb, PSTR("list")) == 0)
+    {
+        for (uint8_t i = 0; i < PARAM_COUNT; i++)
+        {
+            print(stream, (JarParamId)i);
+        }
+    }
+    else if (strcmp_P(verb, PSTR("get")) == 0 && id >= 0)
+    {
+        print(stream, (JarParamId)id);
+    }
+    else if (strcmp_P(verb, PSTR("set")) == 0 && id >= 0 && value)
+    {
+        set((JarParamId)id, atol(value));
+        print(stream, (JarParamId)id);
+    }
+    else if (strcmp_P(verb, PSTR("save")) == 0)
+    {
+        save();
+        stream.println(F("saved"));
+    }
+    else
+    {
+        stream.println(F("?"));
+    }
+}
+
+#endif
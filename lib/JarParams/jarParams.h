@@ -0,0 +1,106 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <Arduino.h>
+
+// Bump this whenever parameters are added, removed or reordered. An
+// EEPROM image with another version is ignored and the defaults are
+// used instead. Also bump it when the unit of a parameter changes.
+#define PARAMS_VERSION 6
+#define PARAMS_EEPROM_ADDRESS 0
+
+// Compile-time keys of all tunable values. The defaults and limits
+// are listed in the same order in jarParams.cpp.
+enum JarParamId : uint8_t
+{
+  PARAM_GYRO_THRESHOLD,
+  PARAM_ACCEL_THRESHOLD,
+  PARAM_COUNTS_PER_REV,
+  PARAM_MOTOR_PERIOD_MS,
+  PARAM_DISPLAY_PERIOD_MS,
+  PARAM_LINE_MIN_0,
+  PARAM_LINE_MIN_1,
+  PARAM_LINE_MIN_2,
+  PARAM_LINE_MAX_0,
+  PARAM_LINE_MAX_1,
+  PARAM_LINE_MAX_2,
+  PARAM_GYRO_BIAS_Z,
+  PARAM_CALIBRATED,
+  PARAM_MOTOR_KP,
+  PARAM_MOTOR_KI,
+  PARAM_MOTOR_KD,
+  PARAM_CLICK_MG,
+  PARAM_IMPACT_MG,
+  PARAM_NOMINAL_MV,
+  PARAM_CURRENT_LIMIT_MA,
+  PARAM_MOTOR_RES_MOHM,
+  PARAM_BEMF_UV_PER_CPS,
+  PARAM_TUNE_SETPOINT,
+  PARAM_TUNE_BIAS,
+  PARAM_TUNE_RELAY,
+  PARAM_TUNE_HYSTERESIS,
+  PARAM_COUNT
+};
+
+// Name (at most 8 characters, to fit the LCD), limits and default of
+// a parameter, stored in program space.
+struct JarParamInfo
+{
+  char name[9];
+  int16_t min;
+  int16_t max;
+  int16_t def;
+  int16_t step;
+};
+
+// The RAM image of the parameters, as stored in EEPROM.
+struct JarParamImage
+{
+  uint8_t version;
+  uint8_t count;
+  int16_t values[PARAM_COUNT];
+  uint16_t crc;
+};
+
+#define PARAMS_EEPROM_SIZE sizeof(JarParamImage)
+
+class JarParams
+{
+public:
+  JarParams();
+
+  // Reads the image from EEPROM. Returns false and falls back to the
+  // defaults if the version or CRC does not match.
+  bool load();
+  void save();
+  void setDefaults();
+
+  int16_t get(JarParamId id) const { return image.values[id]; }
+  template <JarParamId id>
+  int16_t get() const
+  {
+    static_assert(id < PARAM_COUNT, "unknown parameter");
+    return image.values[id];
+  }
+  // Both clamp to the limits of the parameter.
+  void set(JarParamId id, int32_t value);
+  void step(JarParamId id, int8_t direction);
+
+  static void info(JarParamId id, JarParamInfo *info);
+
+  // Handles "list", "get <name>", "set <name> <value>" and "save"
+  // commands, one per line. Call this regularly.
+  void poll(Stream &stream);
+
+private:
+  static uint16_t crc(const JarParamImage &image);
+  static int8_t find(const char *name);
+  void print(Stream &stream, JarParamId id);
+  void command(Stream &stream);
+
+  JarParamImage image;
+  char line[24];
+  uint8_t lineLength;
+};
+
+#endif
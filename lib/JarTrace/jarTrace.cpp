@@ -0,0 +1,371 @@
+#include <jarTrace.h>
+#include <jarParams.h>
+#include <avr/eeprom.h>
+
+#ifndef TRACE_CPP
+#define TRACE_CPP
+
+static_assert(PARAMS_EEPROM_ADDRESS + PARAMS_EEPROM_SIZE <= TRACE_EEPROM_ADDRESS,
+              "the trace overlaps the parameters in EEPROM");
+
+// Payload size of each record type, after the type and time bytes.
+static const uint8_t payloadSize[] PROGMEM = {2, 1, 4, 6, 3, 12, 2, 1};
+
+JarTrace::JarTrace()
+{
+    mask = 0;
+    stream = 0;
+    dropped = 0;
+}
+
+void JarTrace::startSerial(Stream &stream, uint8_t mask)
+{
+    this->stream = &stream;
+    this->mask = 0;
+    put(TRACE_MAGIC_0);
+    put(TRACE_MAGIC_1);
+    put(TRACE_VERSION);
+    lastTime = millis();
+    memset(&lastEncoders, 0, sizeof(lastEncoders));
+    encodersRecorded = false;
+    dropped = 0;
+    this->mask = mask;
+}
+
+void JarTrace::startEeprom(uint8_t mask)
+{
+    stream = 0;
+    this->mask = 0;
+    bufferHead = bufferTail = 0;
+    eepromAddress = TRACE_EEPROM_ADDRESS + 2;
+    put(TRACE_MAGIC_0);
+    put(TRACE_MAGIC_1);
+    put(TRACE_VERSION);
+    lastTime = millis();
+    memset(&lastEncoders, 0, sizeof(lastEncoders));
+    encodersRecorded = false;
+    dropped = 0;
+    this->mask = mask;
+}
+
+void JarTrace::stop()
+{
+    if (!stream && mask)
+    {
+        while (bufferHead != bufferTail)
+        {
+            eeprom_busy_wait();
+            flush();
+        }
+        eeprom_update_word((uint16_t *)TRACE_EEPROM_ADDRESS,
+                           eepromAddress - (TRACE_EEPROM_ADDRESS + 2));
+    }
+    mask = 0;
+}
+
+void JarTrace::put(uint8_t b)
+{
+    if (stream)
+    {
+        stream->write(b);
+        return;
+    }
+
+    uint8_t next = (bufferHead + 1) % TRACE_BUFFER_SIZE;
+    if (next == bufferTail)
+    {
+        dropped++;
+        return;
+    }
+    buffer[bufferHead] = b;
+    bufferHead = next;
+}
+
+void JarTrace::putWord(uint16_t w)
+{
+    put(w & 0xFF);
+    put(w >> 8);
+}
+
+void JarTrace::flush()
+{
+    while (bufferHead != bufferTail && eeprom_is_ready())
+    {
+        if (eepromAddress >= TRACE_EEPROM_END)
+        {
+            dropped += (uint8_t)(bufferHead - bufferTail + TRACE_BUFFER_SIZE) % TRACE_BUFFER_SIZE;
+            bufferTail = bufferHead;
+            return;
+        }
+        eeprom_write_byte((uint8_t *)(uintptr_t)eepromAddress++, buffer[bufferTail]);
+        bufferTail = (bufferTail + 1) % TRACE_BUFFER_SIZE;
+    }
+}
+
+// Writes the type and time of a record if its type is recorded.
+bool JarTrace::begin(uint8_t type, uint16_t time)
+{
+    if (!(mask & TRACE_MASK(type & 0x0F)))
+    {
+        return false;
+    }
+
+    uint16_t gap = time - lastTime;
+    lastTime = time;
+    if (gap > 255)
+    {
+        put(TRACE_TIME);
+        putWord(gap);
+        gap = 0;
+    }
+    put(type);
+    put(gap);
+    return true;
+}
+
+void JarTrace::recordButton(uint16_t time, char button)
+{
+    if (begin(TRACE_BUTTON, time))
+    {
+        put(button);
+    }
+}
+
+void JarTrace::recordHeld(uint16_t time, uint8_t held)
+{
+    if (begin(TRACE_HELD, time))
+    {
+        put(held);
+    }
+}
+
+void JarTrace::recordEncoders(const JarEncoderSample &sample)
+{
+    if (encodersRecorded && (uint16_t)(sample.time - lastEncoders.time) < TRACE_ENCODER_PERIOD_MS)
+    {
+        return;
+    }
+    if (sample.left == lastEncoders.left && sample.right == lastEncoders.right)
+    {
+        return;
+    }
+    if (begin(TRACE_ENCODERS, sample.time))
+    {
+        encodersRecorded = true;
+        putWord(sample.left - lastEncoders.left);
+        putWord(sample.right - lastEncoders.right);
+        lastEncoders = sample;
+    }
+}
+
+void JarTrace::recordLine(const JarLineSample &sample)
+{
+    if (begin(TRACE_LINE | (sample.emittersOn ? TRACE_EMITTERS_ON : 0), sample.time))
+    {
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            putWord(sample.values[i]);
+        }
+    }
+}
+
+// The six counts are at most 6, so they are packed 3 bits each.
+void JarTrace::recordProx(const JarProxSample &sample)
+{
+    if (begin(TRACE_PROX, sample.time))
+    {
+        uint32_t packed = 0;
+        for (uint8_t i = 0; i < 6; i++)
+        {
+            packed |= (uint32_t)(sample.counts[i] & 7) << (3 * i);
+        }
+        put(packed);
+        put(packed >> 8);
+        put(packed >> 16);
+    }
+}
+
+void JarTrace::recordImu(const JarImuSample &sample)
+{
+    if (begin(TRACE_IMU, sample.time))
+    {
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            putWord(sample.accel[i]);
+        }
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            putWord(sample.gyro[i]);
+        }
+    }
+}
+
+void JarTrace::recordBattery(const JarBatterySample &sample)
+{
+    if (begin(TRACE_BATTERY, sample.time))
+    {
+        putWord(sample.millivolts);
+    }
+}
+
+uint16_t JarTrace::eepromLength()
+{
+    uint16_t length = eeprom_read_word((const uint16_t *)TRACE_EEPROM_ADDRESS);
+    if (length > TRACE_EEPROM_END - (TRACE_EEPROM_ADDRESS + 2))
+    {
+        return 0;
+    }
+    return length;
+}
+
+void JarTrace::dumpEeprom(Stream &stream)
+{
+    uint16_t length = eepromLength();
+    for (uint16_t i = 0; i < length; i++)
+    {
+        stream.write(eeprom_read_byte((const uint8_t *)(uintptr_t)(TRACE_EEPROM_ADDRESS + 2 + i)));
+    }
+}
+
+JarTraceReader::JarTraceReader(const uint8_t *data, uint32_t length)
+{
+    this->data = data;
+    this->length = length;
+    time = 0;
+    memset(&encoders, 0, sizeof(encoders));
+
+    if (length >= 3 && data[0] == TRACE_MAGIC_0 && data[1] == TRACE_MAGIC_1 &&
+        data[2] == TRACE_VERSION)
+    {
+        pos = 3;
+    }
+    else
+    {
+        pos = 0;
+    }
+}
+
+uint8_t JarTraceReader::get()
+{
+    return data[pos++];
+}
+
+uint16_t JarTraceReader::getWord()
+{
+    uint16_t w = get();
+    return w | (get() << 8);
+}
+
+bool JarTraceReader::next(JarTraceRecord &record)
+{
+    while (valid() && pos + 2 <= length)
+    {
+        uint8_t typeByte = get();
+        uint8_t type = typeByte & 0x0F;
+        if (type > TRACE_HELD)
+        {
+            return false;
+        }
+
+        // Gap records have no time byte of their own.
+        uint8_t size = pgm_read_byte(&payloadSize[type]) + (type != TRACE_TIME);
+        if (pos + size > length)
+        {
+            return false;
+        }
+
+        if (type == TRACE_TIME)
+        {
+            time += getWord();
+            continue;
+        }
+
+        time += get();
+        record.type = type;
+        record.time = time;
+
+        switch (type)
+        {
+        case TRACE_BUTTON:
+            record.button = get();
+            break;
+
+        case TRACE_HELD:
+            record.held = get();
+            break;
+
+        case TRACE_ENCODERS:
+            encoders.left += getWord();
+            encoders.right += getWord();
+            encoders.time = time;
+            record.encoders = encoders;
+            break;
+
+        case TRACE_LINE:
+            record.line.time = time;
+            record.line.emittersOn = typeByte & TRACE_EMITTERS_ON;
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                record.line.values[i] = getWord();
+            }
+            break;
+
+        case TRACE_PROX:
+        {
+            uint32_t packed = get();
+            packed |= (uint32_t)get() << 8;
+            packed |= (uint32_t)get() << 16;
+            record.prox.time = time;
+            for (uint8_t i = 0; i < 6; i++)
+            {
+                record.prox.counts[i] = (packed >> (3 * i)) & 7;
+            }
+            break;
+        }
+
+        case TRACE_IMU:
+            record.imu.time = time;
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                record.imu.accel[i] = getWord();
+            }
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                record.imu.gyro[i] = getWord();
+            }
+            break;
+
+        case TRACE_BATTERY:
+            record.battery.time = time;
+            record.battery.millivolts = getWord();
+            break;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool JarTraceReader::publish(const JarTraceRecord &record, JarBus &bus)
+{
+    switch (record.type)
+    {
+    case TRACE_ENCODERS:
+        bus.encoders.publish(record.encoders);
+        return true;
+    case TRACE_LINE:
+        bus.line.publish(record.line);
+        return true;
+    case TRACE_PROX:
+        bus.prox.publish(record.prox);
+        return true;
+    case TRACE_IMU:
+        bus.imu.publish(record.imu);
+        return true;
+    case TRACE_BATTERY:
+        bus.battery.publish(record.battery);
+        return true;
+    }
+    return false;
+}
+
+#endif
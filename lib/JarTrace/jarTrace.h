@@ -0,0 +1,190 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <jarBus.h>
+
+// Record types. Each record starts with a type byte and the time in
+// ms since the previous record; gaps over 255 ms are bridged with a
+// TRACE_TIME record holding a 16-bit gap.
+#define TRACE_TIME 0
+#define TRACE_BUTTON 1
+#define TRACE_ENCODERS 2
+#define TRACE_LINE 3
+#define TRACE_PROX 4
+#define TRACE_IMU 5
+#define TRACE_BATTERY 6
+#define TRACE_HELD 7
+
+// Bits of the held buttons in a TRACE_HELD record.
+#define TRACE_HELD_A 1
+#define TRACE_HELD_B 2
+#define TRACE_HELD_C 4
+
+// Set in the type byte of a TRACE_LINE record taken with emitters on.
+#define TRACE_EMITTERS_ON 0x80
+
+#define TRACE_MASK(type) (1 << (type))
+#define TRACE_ALL 0xFF
+
+// EEPROM writes take 3.4 ms per byte, so only the slow inputs are
+// recorded there by default.
+#define TRACE_EEPROM_MASK (TRACE_MASK(TRACE_BUTTON) | TRACE_MASK(TRACE_HELD) | \
+                           TRACE_MASK(TRACE_BATTERY))
+
+// Encoder totals are recorded at most this often, and only when they
+// changed. Skipped samples lose nothing, as each record carries the
+// counts since the previous one.
+#define TRACE_ENCODER_PERIOD_MS 10
+
+// The EEPROM trace follows the parameter image: a 16-bit length,
+// then the same bytes that are streamed over serial.
+#define TRACE_EEPROM_ADDRESS 64
+#define TRACE_EEPROM_END 1024
+
+#define TRACE_BUFFER_SIZE 64
+
+// Every trace starts with these bytes.
+#define TRACE_MAGIC_0 'J'
+#define TRACE_MAGIC_1 'T'
+#define TRACE_VERSION 2
+
+// Writes timestamped inputs into a compact trace, either straight to
+// a serial stream or to EEPROM through a RAM buffer.
+class JarTrace
+{
+public:
+  JarTrace();
+
+  void startSerial(Stream &stream, uint8_t mask = TRACE_ALL);
+  void startEeprom(uint8_t mask = TRACE_EEPROM_MASK);
+  void stop();
+  bool recording() const { return mask != 0; }
+
+  // Writes buffered bytes to EEPROM as long as it is not busy. Call
+  // this regularly while recording to EEPROM.
+  void flush();
+
+  void recordButton(uint16_t time, char button);
+  void recordHeld(uint16_t time, uint8_t held);
+  void recordEncoders(const JarEncoderSample &sample);
+  void recordLine(const JarLineSample &sample);
+  void recordProx(const JarProxSample &sample);
+  void recordImu(const JarImuSample &sample);
+  void recordBattery(const JarBatterySample &sample);
+
+  // Length of the trace stored in EEPROM, and a way to get it out.
+  static uint16_t eepromLength();
+  static void dumpEeprom(Stream &stream);
+
+  // Bytes lost because the EEPROM buffer was full or EEPROM ran out.
+  uint16_t dropped;
+
+private:
+  bool begin(uint8_t type, uint16_t time);
+  void put(uint8_t b);
+  void putWord(uint16_t w);
+
+  uint8_t mask;
+  Stream *stream;
+  uint16_t lastTime;
+  JarEncoderSample lastEncoders;
+  bool encodersRecorded;
+
+  uint8_t buffer[TRACE_BUFFER_SIZE];
+  uint8_t bufferHead;
+  uint8_t bufferTail;
+  uint16_t eepromAddress;
+};
+
+// Forwards to a JarButton and writes every press, and every change
+// of the buttons held down, into a trace, so that recorded runs can
+// be replayed with the same button input. Every loop calls monitor(),
+// including the menu and demos that read no sensors, so it also
+// writes buffered bytes of an EEPROM trace.
+template <class Buttons>
+class JarTracedButtons
+{
+public:
+  JarTracedButtons(Buttons &buttons, JarTrace &trace)
+    : buttons(buttons), trace(trace), held(0)
+  {
+  }
+
+  char monitor()
+  {
+    char button = buttons.monitor();
+    if (button) { trace.recordButton(millis(), button); }
+    trace.flush();
+    return button;
+  }
+
+  bool aIsPressed() { return track(TRACE_HELD_A, buttons.aIsPressed()); }
+  bool bIsPressed() { return track(TRACE_HELD_B, buttons.bIsPressed()); }
+  bool cIsPressed() { return track(TRACE_HELD_C, buttons.cIsPressed()); }
+
+private:
+  bool track(uint8_t bit, bool pressed)
+  {
+    uint8_t now = pressed ? (held | bit) : (held & ~bit);
+    if (now != held)
+    {
+      held = now;
+      trace.recordHeld(millis(), held);
+    }
+    return pressed;
+  }
+
+  Buttons &buttons;
+  JarTrace &trace;
+  uint8_t held;
+};
+
+// One decoded record. Encoder records carry totals again, rebuilt
+// from the differences stored in the trace.
+struct JarTraceRecord
+{
+  uint8_t type;
+  uint16_t time;
+  union
+  {
+    char button;
+    uint8_t held;
+    JarEncoderSample encoders;
+    JarLineSample line;
+    JarProxSample prox;
+    JarImuSample imu;
+    JarBatterySample battery;
+  };
+};
+
+// Decodes a trace held in memory, for replaying it through the same
+// code that consumes the live data. Lengths are 32 bits, as a serial
+// capture passes 64 KB in about 20 s.
+class JarTraceReader
+{
+public:
+  JarTraceReader(const uint8_t *data, uint32_t length);
+
+  // False if the data does not start with a trace header.
+  bool valid() const { return pos != 0; }
+
+  // Decodes the next record. Returns false at the end of the trace.
+  bool next(JarTraceRecord &record);
+
+  // Publishes a sensor record on the bus. Returns false for records
+  // that have no bus slot (buttons).
+  static bool publish(const JarTraceRecord &record, JarBus &bus);
+
+private:
+  uint8_t get();
+  uint16_t getWord();
+
+  const uint8_t *data;
+  uint32_t length;
+  uint32_t pos;
+  uint16_t time;
+  JarEncoderSample encoders;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include <jarWatchdog.h>
+#include <avr/wdt.h>
+#include <util/atomic.h>
+
+#ifndef WATCHDOG_CPP
+#define WATCHDOG_CPP
+
+#define WATCHDOG_MAGIC 0x5744
+
+// Not cleared by the C runtime at startup, so it survives the reset.
+static JarWatchdogRecord resetRecord __attribute__((section(".noinit")));
+
+JarWatchdogRecord JarWatchdog::lastReset;
+volatile JarWatchdog::Task JarWatchdog::tasks[WATCHDOG_MAX_TASKS];
+volatile uint8_t JarWatchdog::activeTasks = 0;
+void (*JarWatchdog::safeStop)() = 0;
+
+void JarWatchdog::begin(void (*safeStop)())
+{
+    // Latch the reset flags before clearing WDRF, which keeps the
+    // watchdog enabled after a watchdog reset. The other flags are
+    // left for the sketch.
+    uint8_t resetFlags = MCUSR;
+    MCUSR = resetFlags & ~_BV(WDRF);
+    wdt_disable();
+
+    JarWatchdog::safeStop = safeStop;
+
+    // Only a watchdog reset can have left a valid record. After any
+    // other reset the RAM may hold garbage or the record of an
+    // earlier boot.
+    lastReset = resetRecord;
+    if (!(resetFlags & _BV(WDRF)) || lastReset.magic != WATCHDOG_MAGIC)
+    {
+        lastReset.reason = WATCHDOG_REASON_NONE;
+    }
+    resetRecord.magic = 0;
+}
+
+void JarWatchdog::enable()
+{
+    wdt_enable(WDTO_15MS);
+    WDTCSR |= _BV(WDIE);
+}
+
+void JarWatchdog::start(uint8_t task, uint16_t deadlineMs)
+{
+    if (task >= WATCHDOG_MAX_TASKS)
+    {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        tasks[task].deadline = deadlineMs;
+        tasks[task].lastCheckIn = millis();
+        tasks[task].worst = 0;
+        tasks[task].overruns = 0;
+        if (activeTasks == 0)
+        {
+            enable();
+        }
+        activeTasks |= 1 << task;
+    }
+}
+
+void JarWatchdog::stop(uint8_t task)
+{
+    if (task >= WATCHDOG_MAX_TASKS)
+    {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        activeTasks &= ~(1 << task);
+        if (activeTasks == 0)
+        {
+            wdt_disable();
+        }
+    }
+}
+
+void JarWatchdog::checkIn(uint8_t task)
+{
+    if (task >= WATCHDOG_MAX_TASKS)
+    {
+        return;
+    }
+    uint16_t now = millis();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        uint16_t elapsed = now - tasks[task].lastCheckIn;
+        tasks[task].lastCheckIn = now;
+        if (elapsed > tasks[task].worst)
+        {
+            tasks[task].worst = elapsed;
+        }
+        if (elapsed > tasks[task].deadline && tasks[task].overruns < 255)
+        {
+            tasks[task].overruns++;
+        }
+    }
+}
+
+uint16_t JarWatchdog::worstCase(uint8_t task)
+{
+    if (task >= WATCHDOG_MAX_TASKS)
+    {
+        return 0;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        return tasks[task].worst;
+    }
+    return 0;
+}
+
+uint8_t JarWatchdog::overruns(uint8_t task)
+{
+    if (task >= WATCHDOG_MAX_TASKS)
+    {
+        return 0;
+    }
+    return tasks[task].overruns;
+}
+
+void JarWatchdog::tick()
+{
+    uint16_t now = millis();
+    for (uint8_t i = 0; i < WATCHDOG_MAX_TASKS; i++)
+    {
+        if (!(activeTasks & (1 << i)))
+        {
+            continue;
+        }
+
+        uint16_t elapsed = now - tasks[i].lastCheckIn;
+        if (elapsed > tasks[i].deadline)
+        {
+            if (safeStop)
+            {
+                safeStop();
+            }
+            resetRecord.magic = WATCHDOG_MAGIC;
+            resetRecord.reason = WATCHDOG_REASON_DEADLINE;
+            resetRecord.task = i;
+            resetRecord.lateMs = elapsed - tasks[i].deadline;
+
+            // Leave WDIE cleared so the next time-out resets the AVR.
+            return;
+        }
+    }
+
+    // Stay in interrupt mode for another tick.
+    WDTCSR |= _BV(WDIE);
+}
+
+ISR(WDT_vect)
+{
+    JarWatchdog::tick();
+}
+
+#endif
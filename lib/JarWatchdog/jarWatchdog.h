@@ -0,0 +1,70 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <Arduino.h>
+
+// Task indices run from 0 to WATCHDOG_MAX_TASKS - 1; calls with
+// other indices are ignored.
+#define WATCHDOG_MAX_TASKS 4
+
+// Why the last reset happened, as kept across the reset.
+#define WATCHDOG_REASON_NONE 0
+#define WATCHDOG_REASON_DEADLINE 1
+
+struct JarWatchdogRecord
+{
+  uint16_t magic;
+  uint8_t reason;
+  uint8_t task;
+  uint16_t lateMs;
+};
+
+// Supervises periodic tasks with the AVR hardware watchdog.
+//
+// The watchdog runs in interrupt and reset mode with a 16 ms period.
+// Each tick the interrupt checks that every started task has checked
+// in within its deadline. If one has not, it stops the motors through
+// the safeStop callback, stores the task in a record that survives
+// the reset and lets the next watchdog time-out reset the AVR. If
+// interrupts stay disabled the watchdog resets the AVR as well.
+class JarWatchdog
+{
+public:
+  // Reads and clears the record of the previous reset, which only
+  // counts after a watchdog reset. Call this early in setup(), before
+  // MCUSR is cleared; it only clears WDRF.
+  static void begin(void (*safeStop)());
+
+  static void start(uint8_t task, uint16_t deadlineMs);
+  static void stop(uint8_t task);
+  static void checkIn(uint8_t task);
+
+  // Longest time between two check-ins and how often the deadline
+  // was exceeded by less than a watchdog tick, since start().
+  static uint16_t worstCase(uint8_t task);
+  static uint8_t overruns(uint8_t task);
+
+  // The record of the reset before this boot; reason is
+  // WATCHDOG_REASON_NONE unless the watchdog caused it.
+  static JarWatchdogRecord lastReset;
+
+  // Called from the watchdog interrupt.
+  static void tick();
+
+private:
+  struct Task
+  {
+    uint16_t deadline;
+    uint16_t lastCheckIn;
+    uint16_t worst;
+    uint8_t overruns;
+  };
+
+  static void enable();
+
+  static volatile Task tasks[WATCHDOG_MAX_TASKS];
+  static volatile uint8_t activeTasks;
+  static void (*safeStop)();
+};
+
+#endif
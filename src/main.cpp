@@ -10,10 +10,20 @@ try rotating the contrast potentiometer. */
 
 #include <Wire.h>
 #include <Zumo32U4.h>
+#include <jarAssets.h>
+#include <jarAutotune.h>
+#include <jarBus.h>
 #include <jarButton.h>
+#include <jarCollision.h>
+#include <jarDemos.h>
+#include <jarLineFast.h>
 #include <jarMenu.h>
-
-JarButton jb;
+#include <jarMotorOutput.h>
+#include <jarOccupancy.h>
+#include <jarParams.h>
+#include <jarProxMapper.h>
+#include <jarTrace.h>
+#include <jarWatchdog.h>
 
 Zumo32U4LCD lcd;
 Zumo32U4LineSensors lineSensors;
@@ -22,73 +32,199 @@ LSM303 compass;
 L3G gyro;
 Zumo32U4Motors motors;
 Zumo32U4Encoders encoders;
+JarCollision<LSM303> collision(compass);
+JarMotorOutput<Zumo32U4Motors> motorOutput(motors);
+JarLineFast lineFast;
+JarOdometry odometry;
+JarOccupancy proxMap;
+JarProxMapper proxMapper(odometry, proxMap);
+JarParams params;
+JarBus bus;
+JarTrace trace;
+
+typedef JarButton<Zumo32U4Buzzer, Zumo32U4ButtonA, Zumo32U4ButtonB, Zumo32U4ButtonC> ZumoButtons;
+ZumoButtons jb;
+
+// Everything reads the buttons through this, so presses and held
+// buttons end up in the trace.
+typedef JarTracedButtons<ZumoButtons> TracedButtons;
+TracedButtons buttons(jb, trace);
+
+// Tasks supervised by the watchdog.
+#define TASK_MOTORS 0
+
+// How often acquireSensors() reads each sensor, in ms.
+#define LINE_PERIOD_MS 10
+#define PROX_PERIOD_MS 20
+#define IMU_PERIOD_MS 10
+#define BATTERY_PERIOD_MS 100
+#define SPEED_PERIOD_MS 20
+
+// Sensors a loop can ask acquireSensors() for. The encoders and the
+// battery are always read, since the motor output needs them.
+#define SENSE_LINE 0x01
+#define SENSE_PROX 0x02
+#define SENSE_IMU 0x04
+#define SENSE_IMPACTS 0x08
+#define SENSE_NONE 0x00
+#define SENSE_ALL 0x0F
+
+// Emitter mode of the line sensor readings published on the bus.
+uint8_t lineReadMode = QTR_EMITTERS_ON;
+
+// Reads every sensor in the mask whose period has elapsed and
+// publishes the sample on the bus, so each one is read only once no
+// matter how many consumers want it. Loops that use sensor data call
+// this with the SENSE_ bits of the sensors they use; the others are
+// not read at all.
+void acquireSensors(uint8_t sensors)
+{
+  static uint16_t lastLineTime, lastProxTime, lastImuTime, lastBatteryTime;
+  static JarEncoderSample enc, lastSpeedEnc;
+  uint16_t now = millis();
+
+  enc.time = now;
+  enc.left += encoders.getCountsAndResetLeft();
+  enc.right += encoders.getCountsAndResetRight();
+  bus.encoders.publish(enc);
+  trace.recordEncoders(enc);
+
+  // Wheel speeds for the motor current limit.
+  uint16_t speedTime = now - lastSpeedEnc.time;
+  if (speedTime >= SPEED_PERIOD_MS)
+  {
+    motorOutput.setSpeeds(
+      (int32_t)(int16_t)(enc.left - lastSpeedEnc.left) * 1000 / speedTime,
+      (int32_t)(int16_t)(enc.right - lastSpeedEnc.right) * 1000 / speedTime);
+    lastSpeedEnc = enc;
+    motorOutput.update();
+  }
 
-// A couple of simple tunes, stored in program space.
-const char beepBrownout[] PROGMEM = "<c8";
-const char beepWelcome[] PROGMEM = ">g32>>c32";
-const char beepThankYou[] PROGMEM = ">>c32>g32";
-
-// Custom characters for the LCD:
-
-// This character is a back arrow.
-const char backArrow[] PROGMEM = {
-  0b00000,
-  0b00010,
-  0b00001,
-  0b00101,
-  0b01001,
-  0b11110,
-  0b01000,
-  0b00100,
-};
+  if ((sensors & SENSE_LINE) && (uint16_t)(now - lastLineTime) >= LINE_PERIOD_MS)
+  {
+    JarLineSample line;
+    lastLineTime = now;
+    lineSensors.read(line.values, lineReadMode);
+    line.time = now;
+    line.emittersOn = (lineReadMode == QTR_EMITTERS_ON);
+    bus.line.publish(line);
+    trace.recordLine(line);
+  }
 
-// This character is two chevrons pointing up.
-const char forwardArrows[] PROGMEM = {
-  0b00000,
-  0b00100,
-  0b01010,
-  0b10001,
-  0b00100,
-  0b01010,
-  0b10001,
-  0b00000,
-};
+  if ((sensors & SENSE_PROX) && (uint16_t)(now - lastProxTime) >= PROX_PERIOD_MS)
+  {
+    JarProxSample prox;
+    lastProxTime = now;
+    proxSensors.read();
+    prox.time = now;
+    prox.counts[0] = proxSensors.countsLeftWithLeftLeds();
+    prox.counts[1] = proxSensors.countsLeftWithRightLeds();
+    prox.counts[2] = proxSensors.countsFrontWithLeftLeds();
+    prox.counts[3] = proxSensors.countsFrontWithRightLeds();
+    prox.counts[4] = proxSensors.countsRightWithLeftLeds();
+    prox.counts[5] = proxSensors.countsRightWithRightLeds();
+    bus.prox.publish(prox);
+    trace.recordProx(prox);
+  }
 
-// This character is two chevrons pointing down.
-const char reverseArrows[] PROGMEM = {
-  0b00000,
-  0b10001,
-  0b01010,
-  0b00100,
-  0b10001,
-  0b01010,
-  0b00100,
-  0b00000,
-};
+  if ((sensors & SENSE_IMU) && (uint16_t)(now - lastImuTime) >= IMU_PERIOD_MS)
+  {
+    JarImuSample imu;
+    lastImuTime = now;
+    compass.read();
+    gyro.read();
+    imu.time = now;
+    imu.accel[0] = compass.a.x;
+    imu.accel[1] = compass.a.y;
+    imu.accel[2] = compass.a.z;
+    imu.gyro[0] = gyro.g.x;
+    imu.gyro[1] = gyro.g.y;
+    imu.gyro[2] = gyro.g.z;
+    bus.imu.publish(imu);
+    trace.recordImu(imu);
+    collision.updateBaseline(imu.accel);
+  }
 
-// This character is two solid arrows pointing up.
-const char forwardArrowsSolid[] PROGMEM = {
-  0b00000,
-  0b00100,
-  0b01110,
-  0b11111,
-  0b00100,
-  0b01110,
-  0b11111,
-  0b00000,
-};
+  if ((uint16_t)(now - lastBatteryTime) >= BATTERY_PERIOD_MS)
+  {
+    JarBatterySample battery;
+    lastBatteryTime = now;
+    battery.time = now;
+    battery.millivolts = readBatteryMillivolts();
+    bus.battery.publish(battery);
+    trace.recordBattery(battery);
+    motorOutput.setBattery(battery.millivolts);
+  }
 
-// This character is two solid arrows pointing down.
-const char reverseArrowsSolid[] PROGMEM = {
-  0b00000,
-  0b11111,
-  0b01110,
-  0b00100,
-  0b11111,
-  0b01110,
-  0b00100,
-  0b00000,
-};
+  // The LSM303D watches for bumps by itself; this only asks it
+  // whether it saw one.
+  if (sensors & SENSE_IMPACTS)
+  {
+    collision.poll(bus.impacts);
+  }
+
+  trace.flush();
+}
+
+// Gets the encoder counts since the sample in last from the bus
+// and stores the current sample in last.
+void encoderDeltas(JarEncoderSample &last, int16_t *left, int16_t *right)
+{
+  JarEncoderSample now;
+  bus.encoders.read(now);
+  *left = now.left - last.left;
+  *right = now.right - last.right;
+  last = now;
+}
+
+// Shows the longest time between two check-ins of a supervised task
+// and how often it ran past its deadline, on the LCD and over USB
+// serial. Call this after stopping the task.
+void reportTask(uint8_t task)
+{
+  char buf[9];
+  uint16_t worst = JarWatchdog::worstCase(task);
+  uint8_t overruns = JarWatchdog::overruns(task);
+
+  Serial.print(F("task "));
+  Serial.print(task);
+  Serial.print(F(": worst "));
+  Serial.print(worst);
+  Serial.print(F(" ms, overruns "));
+  Serial.println(overruns);
+
+  lcd.clear();
+  sprintf(buf, "Max%4u", worst);
+  lcd.print(buf);
+  lcd.gotoXY(0, 1);
+  sprintf(buf, "Late%3u", overruns);
+  lcd.print(buf);
+  delay(1000);
+}
+
+// Called by the watchdog when a task misses its deadline.
+void stopMotors()
+{
+  motorOutput.stop();
+}
+
+// Applies the motor output parameters.
+void configureMotorOutput()
+{
+  motorOutput.setLimits(params.get<PARAM_NOMINAL_MV>(),
+    params.get<PARAM_CURRENT_LIMIT_MA>(),
+    params.get<PARAM_MOTOR_RES_MOHM>(),
+    params.get<PARAM_BEMF_UV_PER_CPS>());
+}
+
+// Applies the collision thresholds.
+void configureCollision()
+{
+  collision.begin(params.get<PARAM_CLICK_MG>(), params.get<PARAM_IMPACT_MG>());
+}
+
+// The tunes, custom characters and menu strings are packed into
+// program space from assets/jarAssets.txt by tools/gen_assets.py.
 
 void loadCustomCharacters()
 {
@@ -97,7 +233,7 @@ void loadCustomCharacters()
   // arrow; other characters are loaded by individual demos as
   // needed.
 
-  lcd.loadCustomCharacter(backArrow, 7);
+  lcd.loadCustomCharacter(JAR_ASSET(BACK_ARROW), 7);
 }
 
 // Assigns #0-6 to be bar graph characters.
@@ -119,10 +255,10 @@ void loadCustomCharactersBarGraph()
 // Assigns #0-4 to be arrow symbols.
 void loadCustomCharactersMotorDirs()
 {
-  lcd.loadCustomCharacter(forwardArrows, 0);
-  lcd.loadCustomCharacter(reverseArrows, 1);
-  lcd.loadCustomCharacter(forwardArrowsSolid, 2);
-  lcd.loadCustomCharacter(reverseArrowsSolid, 3);
+  lcd.loadCustomCharacter(JAR_ASSET(FORWARD_ARROWS), 0);
+  lcd.loadCustomCharacter(JAR_ASSET(REVERSE_ARROWS), 1);
+  lcd.loadCustomCharacter(JAR_ASSET(FORWARD_ARROWS_SOLID), 2);
+  lcd.loadCustomCharacter(JAR_ASSET(REVERSE_ARROWS_SOLID), 3);
 }
 
 // Clears the LCD and puts [back_arrow]B on the second line
@@ -142,7 +278,7 @@ void ledDemo()
 
   uint8_t state = 3;
   static uint16_t lastUpdateTime = millis() - 2000;
-  while (jb.monitor() != 'B')
+  while (buttons.monitor() != 'B')
   {
     if ((uint16_t)(millis() - lastUpdateTime) >= 500)
     {
@@ -187,13 +323,6 @@ void ledDemo()
   ledGreen(0);
 }
 
-void printBar(uint8_t height)
-{
-  if (height > 8) { height = 8; }
-  static const char barChars[] = {' ', 0, 1, 2, 3, 4, 5, 6, -128};
-  lcd.print(barChars[height]);
-}
-
 // Display line sensor readings. Holding button C turns off
 // the IR emitters.
 void lineSensorDemo()
@@ -203,41 +332,18 @@ void lineSensorDemo()
   lcd.gotoXY(6, 1);
   lcd.print('C');
 
-  unsigned int lineSensorValues[3];
+  JarLineView<Zumo32U4LCD> view(lcd);
 
-  while (jb.monitor() != 'B')
+  while (buttons.monitor() != 'B')
   {
-    bool emittersOff = jb.bIsPressed();
-
-    if (emittersOff)
-    {
-      lineSensors.read(lineSensorValues, QTR_EMITTERS_OFF);
-    }
-    else
-    {
-      lineSensors.read(lineSensorValues, QTR_EMITTERS_ON);
-    }
+    bool emittersOff = buttons.bIsPressed();
 
-    lcd.gotoXY(1, 0);
-    for (uint8_t i = 0; i < 3; i++)
-    {
-      uint8_t barHeight = map(lineSensorValues[i], 0, 2000, 0, 8);
-      printBar(barHeight);
-      lcd.print(' ');
-    }
-
-    // Display an indicator of whether emitters are on or
-    // off.
-    lcd.gotoXY(7, 1);
-    if (emittersOff)
-    {
-      lcd.print('\xa5');  // centered dot
-    }
-    else
-    {
-      lcd.print('*');
-    }
+    lineReadMode = emittersOff ? QTR_EMITTERS_OFF : QTR_EMITTERS_ON;
+    acquireSensors(SENSE_LINE);
+    view.step(bus);
   }
+
+  lineReadMode = QTR_EMITTERS_ON;
 }
 
 // Display proximity sensor readings.
@@ -246,30 +352,64 @@ void proxSensorDemo()
   loadCustomCharactersBarGraph();
   displayBackArrow();
 
-  while (jb.monitor() != 'B')
+  JarProxView<Zumo32U4LCD> view(lcd);
+
+  while (buttons.monitor() != 'B')
   {
     bool proxLeftActive = proxSensors.readBasicLeft();
     bool proxFrontActive = proxSensors.readBasicFront();
     bool proxRightActive = proxSensors.readBasicRight();
-    proxSensors.read();
-
-    lcd.gotoXY(0, 0);
-    printBar(proxSensors.countsLeftWithLeftLeds());
-    printBar(proxSensors.countsLeftWithRightLeds());
-    lcd.print(' ');
-    printBar(proxSensors.countsFrontWithLeftLeds());
-    printBar(proxSensors.countsFrontWithRightLeds());
-    lcd.print(' ');
-    printBar(proxSensors.countsRightWithLeftLeds());
-    printBar(proxSensors.countsRightWithRightLeds());
+    acquireSensors(SENSE_PROX);
+    view.step(bus);
 
     // On the last 3 characters of the second line, display
     // basic readings of the sensors taken without sending
     // IR pulses.
     lcd.gotoXY(5, 1);
-    printBar(proxLeftActive);
-    printBar(proxFrontActive);
-    printBar(proxRightActive);
+    jarPrintBar(lcd, proxLeftActive);
+    jarPrintBar(lcd, proxFrontActive);
+    jarPrintBar(lcd, proxRightActive);
+  }
+}
+
+// Builds an occupancy grid from the proximity sensors while the
+// robot is pushed around. The first line shows the distance to the
+// nearest obstacle ahead, the second line the time in microseconds
+// one grid update took.
+void proxMapDemo()
+{
+  displayBackArrow();
+
+  uint16_t updateTime = 0;
+  char buf[9];
+
+  acquireSensors(SENSE_PROX);
+  proxMapper.begin(bus, millis());
+
+  while (buttons.monitor() != 'B')
+  {
+    acquireSensors(SENSE_PROX);
+
+    uint16_t startTime = micros();
+    if (proxMapper.update(bus, millis()))
+    {
+      updateTime = micros() - startTime;
+    }
+
+    uint16_t ahead = proxMapper.ahead();
+    lcd.gotoXY(0, 0);
+    if (ahead == 0xFFFF)
+    {
+      lcd.print(F("  --- mm"));
+    }
+    else
+    {
+      sprintf(buf, "%5u mm", ahead);
+      lcd.print(buf);
+    }
+    lcd.gotoXY(3, 1);
+    sprintf(buf, "%4uu", updateTime);
+    lcd.print(buf);
   }
 }
 
@@ -281,36 +421,69 @@ void initInertialSensors()
   compass.enableDefault();
   gyro.init();
   gyro.enableDefault();
+  configureCollision();
 }
 
-// Given 3 readings for axes x, y, and z, prints the sign
-// and axis of the largest reading unless it is below the
-// given threshold.
-void printLargestAxis(int16_t x, int16_t y, int16_t z, uint16_t threshold)
+// Reads the line sensors as fast as the calibrated timeouts allow
+// and shows which sensors see the line ('#'), the reads per second,
+// and the mean error (E) and decision mismatches (M) against full
+// reads. Button C switches between deciding with the emitters on
+// only and alternating emitters-on and emitters-off reads.
+void lineFastDemo()
 {
-  int16_t largest = x;
-  char axis = 'X';
+  displayBackArrow();
 
-  if (abs(y) > abs(largest))
-  {
-    largest = y;
-    axis = 'Y';
-  }
-  if (abs(z) > abs(largest))
+  // Uncalibrated, every sensor waits the full timeout and reads
+  // light, which would only look like a broken sensor.
+  if (!params.get<PARAM_CALIBRATED>())
   {
-    largest = z;
-    axis = 'Z';
+    lcd.print(F("Calib1st"));
+    while (buttons.monitor() != 'B') {}
+    return;
   }
 
-  if (abs(largest) < threshold)
-  {
-    lcd.print("  ");
-  }
-  else
+  lineFast.resetStats();
+
+  bool alternate = false;
+  uint16_t values[LINE_FAST_SENSORS];
+  uint8_t dark = 0;
+  uint16_t lastDisplayTime = millis();
+  char button;
+  while ((button = buttons.monitor()) != 'B')
   {
-    bool positive = (largest > 0);
-    lcd.print(positive ? '+' : '-');
-    lcd.print(axis);
+    if (button == 'C')
+    {
+      alternate = !alternate;
+      lineFast.resetStats();
+    }
+
+    if (alternate)
+    {
+      lineFast.readAlternating();
+      dark = lineFast.darkMask();
+    }
+    else
+    {
+      dark = lineFast.read(values, true, true);
+    }
+
+    if ((uint16_t)(millis() - lastDisplayTime) >= 200)
+    {
+      lastDisplayTime = millis();
+      char buf[9];
+      lcd.gotoXY(0, 0);
+      for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+      {
+        lcd.print((dark & (1 << i)) ? '#' : '.');
+      }
+      lcd.print(alternate ? '~' : ' ');
+      sprintf(buf, "%4u", lineFast.samplesPerSecond());
+      lcd.print(buf);
+
+      lcd.gotoXY(2, 1);
+      sprintf(buf, "E%2uM%u", min(lineFast.meanError(), 99), min(lineFast.mismatches(), 9));
+      lcd.print(buf);
+    }
   }
 }
 
@@ -328,23 +501,48 @@ void inertialDemo()
   lcd.gotoXY(4, 1);
   lcd.print(F("Up"));
 
-  while (jb.monitor() != 'B')
+  JarInertialView<Zumo32U4LCD> view(lcd);
+
+  while (buttons.monitor() != 'B')
   {
-    compass.read();
-    gyro.read();
+    acquireSensors(SENSE_IMU);
+    view.step(bus, params.get<PARAM_GYRO_BIAS_Z>(), params.get<PARAM_GYRO_THRESHOLD>(),
+      params.get<PARAM_ACCEL_THRESHOLD>());
+  }
+}
 
-    lcd.gotoXY(6, 0);
-    printLargestAxis(gyro.g.x, gyro.g.y, gyro.g.z, 2000);
-    lcd.gotoXY(6, 1);
-    printLargestAxis(compass.a.x, compass.a.y, compass.a.z, 200);
+// Shows the collisions and taps detected by the accelerometer:
+// how many, and the strength in mg and direction in degrees of the
+// last one. A strength marked with '>' is the threshold the bump
+// crossed, not its peak.
+void impactDemo()
+{
+  displayBackArrow();
+
+  JarStream<JarImpactEvent, 8>::Reader impacts(bus.impacts);
+  JarImpactEvent event;
+  uint16_t count = 0;
+  char buf[9];
+
+  while (buttons.monitor() != 'B')
+  {
+    acquireSensors(SENSE_IMPACTS);
+
+    while (impacts.next(event))
+    {
+      count++;
+      lcd.gotoXY(0, 0);
+      sprintf(buf, "%c%4u%3u", (event.source & IMPACT_AT_LEAST) ? '>' : ' ',
+        event.magnitude, (uint16_t)event.direction * 360 / 256);
+      lcd.print(buf);
+      lcd.gotoXY(4, 1);
+      sprintf(buf, "%4u", count);
+      lcd.print(buf);
+    }
   }
 }
 
-// Provides an interface to test the motors. Holding button A or C
-// causes the left or right motor to accelerate; releasing the
-// button causes the motor to decelerate. Tapping the button while
-// the motor is not running reverses the direction it runs.
-//
+// Provides an interface to test the motors; see JarMotorPanel.
 // If the showEncoders argument is true, encoder counts are
 // displayed on the first line of the LCD; otherwise, an
 // instructional message is shown.
@@ -355,162 +553,31 @@ void motorDemoHelper(bool showEncoders)
   lcd.gotoXY(1, 1);
   lcd.print(F("A \7B C"));
 
-  int16_t leftSpeed = 0, rightSpeed = 0;
-  int8_t leftDir = 1, rightDir = 1;
-  uint16_t lastUpdateTime = millis() - 100;
-  uint8_t btnCountA = 0, btnCountC = 0, instructCount = 0;
-
-  int16_t encCountsLeft = 0, encCountsRight = 0;
-  char buf[4];
+  JarMotorPanel<Zumo32U4LCD, TracedButtons, JarMotorOutput<Zumo32U4Motors> >
+    panel(lcd, buttons, motorOutput, showEncoders);
 
-  while (jb.monitor() != 'B')
-  {
-    encCountsLeft += encoders.getCountsAndResetLeft();
-    if (encCountsLeft < 0) { encCountsLeft += 1000; }
-    if (encCountsLeft > 999) { encCountsLeft -= 1000; }
+  acquireSensors(SENSE_NONE);
+  panel.begin(bus, millis());
 
-    encCountsRight += encoders.getCountsAndResetRight();
-    if (encCountsRight < 0) { encCountsRight += 1000; }
-    if (encCountsRight > 999) { encCountsRight -= 1000; }
+  // A blocked wheel stops the encoder counts from advancing while a
+  // wheel is turned once; if that takes longer than this the
+  // watchdog stops the motors and resets.
+  JarWatchdog::start(TASK_MOTORS, 500);
 
-    // Update the LCD and motors every 50 ms.
-    if ((uint16_t)(millis() - lastUpdateTime) > 50)
+  while (buttons.monitor() != 'B')
+  {
+    acquireSensors(SENSE_NONE);
+    if (panel.step(bus, millis(), params.get<PARAM_MOTOR_PERIOD_MS>(),
+          params.get<PARAM_COUNTS_PER_REV>()))
     {
-      lastUpdateTime = millis();
-
-      lcd.gotoXY(0, 0);
-      if (showEncoders)
-      {
-        sprintf(buf, "%03d", encCountsLeft);
-        lcd.print(buf);
-        lcd.gotoXY(5, 0);
-        sprintf(buf, "%03d", encCountsRight);
-        lcd.print(buf);
-      }
-      else
-      {
-        // Cycle the instructions every 2 seconds.
-        if (instructCount == 0)
-        {
-          lcd.print("Hold=run");
-        }
-        else if (instructCount == 40)
-        {
-          lcd.print("Tap=flip");
-        }
-        if (++instructCount == 80) { instructCount = 0; }
-      }
-
-      if (jb.aIsPressed())
-      {
-        if (btnCountA < 4)
-        {
-          btnCountA++;
-        }
-        else
-        {
-          // Button has been held for more than 200 ms, so
-          // start running the motor.
-          leftSpeed += 15;
-        }
-      }
-      else
-      {
-        if (leftSpeed == 0 && btnCountA > 0 && btnCountA < 4)
-        {
-          // Motor isn't running and button was pressed for
-          // 200 ms or less, so flip the motor direction.
-          // leftDir = -leftDir;
-
-          // start the motor and stop when the encoders read a summized value >900
-          // this is a test if the value 900 is a complete rotation.
-          encCountsLeft = 0;
-          motors.setLeftSpeed(50);
-          while(encCountsLeft < 900) {
-            encCountsLeft += encoders.getCountsAndResetLeft();
-
-            lcd.gotoXY(0, 0);
-            sprintf(buf, "%03d", encCountsLeft);
-            lcd.print(buf);
-          };
-          motors.setLeftSpeed(0);
-        }
-        btnCountA = 0;
-        leftSpeed -= 30;
-      }
-
-      if (jb.cIsPressed())
-      {
-        if (btnCountC < 4)
-        {
-          btnCountC++;
-        }
-        else
-        {
-          // Button has been held for more than 200 ms, so
-          // start running the motor.
-          rightSpeed += 15;
-        }
-      }
-      else
-      {
-        if (rightSpeed == 0 && btnCountC > 0 && btnCountC < 4)
-        {
-          // Motor isn't running and button was pressed for
-          // 200 ms or less, so flip the motor direction.
-          // rightDir = -rightDir;
-
-          encCountsRight = 0;
-          motors.setRightSpeed(50);
-          while(encCountsRight < 900) {
-            encCountsRight += encoders.getCountsAndResetRight();
-
-            lcd.gotoXY(5, 0);
-            sprintf(buf, "%03d", encCountsRight);
-            lcd.print(buf);
-          };
-          motors.setRightSpeed(0);
-        }
-        btnCountC = 0;
-        rightSpeed -= 30;
-      }
-
-      leftSpeed = constrain(leftSpeed, 0, 400);
-      rightSpeed = constrain(rightSpeed, 0, 400);
-
-      motors.setSpeeds(leftSpeed * leftDir, rightSpeed * rightDir);
-
-      lcd.gotoXY(1,1);
-      lcd.print(btnCountA);
-      lcd.gotoXY(6,1);
-      lcd.print(btnCountC);
-
-      // Display arrows pointing the appropriate direction
-      // (solid if the motor is running, chevrons if not).
-      lcd.gotoXY(0, 1);
-      if (leftSpeed == 0)
-      {
-        lcd.print((leftDir > 0) ? '\0' : '\1');
-      }
-      else
-      {
-        lcd.print((leftDir > 0) ? '\2' : '\3');
-      }
-      lcd.gotoXY(7, 1);
-      if (rightSpeed == 0)
-      {
-        lcd.print((rightDir > 0) ? '\0' : '\1');
-      }
-      else
-      {
-        lcd.print((rightDir > 0) ? '\2' : '\3');
-      }
+      JarWatchdog::checkIn(TASK_MOTORS);
     }
   }
-  motors.setSpeeds(0, 0);
+  motorOutput.setEfforts(0, 0);
+  JarWatchdog::stop(TASK_MOTORS);
+  reportTask(TASK_MOTORS);
 }
 
-
 // Motor demo with instructions.
 void motorDemo()
 {
@@ -535,52 +602,30 @@ E|  3|----A---A----------------A-------
 R|  
 --c-c-c-c--<G---<A---c-<A-c---c-<A-c-<A-D-D-d-D-d--d-c-<A-<G-<A-<g---c-<A-c-<A-D-D-d-D-d--d-c-<A-c-D-f-
 */
-const char fugue[] PROGMEM =
-  "! V10T120O5L16agafaea dac+adaea fa<aa<bac#a dac#adaea f"
-  "O6dcd<b-d<ad<g d<f+d<gd<ad<b- d<dd<ed<f+d<g d<f+d<gd<ad"
-  "L8MS<b-d<b-d MLe-<ge-<g MSc<ac<a MLd<fd<f O5MSb-gb-g"
-  "ML>c#e>c#e MS afaf ML gc#gc# MS fdfd ML e<b-e<b-"
-  "O6L16ragafaea dac#adaea fa<aa<bac#a dac#adaea faeadaca"
-  "<b-acadg<b-g egdgcg<b-g <ag<b-gcf<af dfcf<b-f<af"
-  "<gf<af<b-e<ge c#e<b-e<ae<ge <fe<ge<ad<fd"
-  "O5e>ee>ef>df>d b->c#b->c#a>df>d e>ee>ef>df>d"
-  "e>d>c#>db>d>c#b >c#agaegfe fO6dc#dfdc#<b c#4";
-
-const char fugueTitle[] PROGMEM =
-  "       Fugue in D Minor - by J.S. Bach       ";
 
 // Play a song on the buzzer and display its title.
 void musicDemo()
 {
   displayBackArrow();
 
-  uint8_t fugueTitlePos = 0;
+  JarMarquee fugueTitle(ASSET_FUGUE_TITLE);
   uint16_t lastShiftTime = millis() - 2000;
 
-  while (jb.monitor() != 'B')
+  while (buttons.monitor() != 'B')
   {
-    // Shift the song title to the left every 250 ms.
-    if ((uint16_t)(millis() - lastShiftTime) > 250)
+    // Shift the song title to the left every ShowMs (250 ms by default).
+    if ((uint16_t)(millis() - lastShiftTime) > params.get<PARAM_DISPLAY_PERIOD_MS>())
     {
       lastShiftTime = millis();
 
       lcd.gotoXY(0, 0);
-      for (uint8_t i = 0; i < 8; i++)
-      {
-        char c = pgm_read_byte(fugueTitle + fugueTitlePos + i);
-        lcd.print(c);
-      }
-      fugueTitlePos++;
-
-      if (fugueTitlePos + 8 >= strlen(fugueTitle))
-      {
-        fugueTitlePos = 0;
-      }
+      fugueTitle.render(lcd);
+      fugueTitle.advance();
     }
 
     if (!jb.buzzer.isPlaying())
     {
-      jb.buzzer.playFromProgramSpace(fugue);
+      jb.buzzer.playFromProgramSpace(JAR_ASSET(FUGUE));
     }
   }
 }
@@ -594,13 +639,17 @@ void powerDemo()
   uint16_t lastDisplayTime = millis() - 2000;
   char buf[6];
 
-  while (jb.monitor() != 'B')
+  while (buttons.monitor() != 'B')
   {
-    if ((uint16_t)(millis() - lastDisplayTime) > 250)
+    acquireSensors(SENSE_NONE);
+
+    if ((uint16_t)(millis() - lastDisplayTime) > params.get<PARAM_DISPLAY_PERIOD_MS>())
     {
       bool usbPower = usbPowerPresent();
 
-      uint16_t batteryLevel = readBatteryMillivolts();
+      JarBatterySample battery;
+      bus.battery.read(battery);
+      uint16_t batteryLevel = battery.millivolts;
 
       lastDisplayTime = millis();
       lcd.gotoXY(0, 0);
@@ -614,23 +663,301 @@ void powerDemo()
   }
 }
 
+// Copies the line sensor calibration stored in the parameters
+// into the line sensor object, so it does not have to be redone
+// after every reset.
+void applyCalibration()
+{
+  if (!params.get<PARAM_CALIBRATED>()) { return; }
+
+  // The first call allocates the calibration arrays.
+  lineSensors.calibrate();
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    lineSensors.calibratedMinimumOn[i] = params.get((JarParamId)(PARAM_LINE_MIN_0 + i));
+    lineSensors.calibratedMaximumOn[i] = params.get((JarParamId)(PARAM_LINE_MAX_0 + i));
+  }
+  lineFast.setCalibration(lineSensors.calibratedMinimumOn, lineSensors.calibratedMaximumOn);
+}
+
+// Spins in place over a line to calibrate the line sensors, then
+// measures the gyro bias while standing still, and stores both.
+void calibrateDemo()
+{
+  lcd.clear();
+  lcd.print(F("Calib..."));
+  delay(1000);
+
+  lineSensors.resetCalibration();
+  for (uint16_t i = 0; i < 120; i++)
+  {
+    if (i > 30 && i <= 90)
+    {
+      motorOutput.setEfforts(-200, 200);
+    }
+    else
+    {
+      motorOutput.setEfforts(200, -200);
+    }
+    lineSensors.calibrate();
+  }
+  motorOutput.setEfforts(0, 0);
+  delay(500);
+
+  int32_t gyroSum = 0;
+  for (uint8_t i = 0; i < 128; i++)
+  {
+    gyro.read();
+    gyroSum += gyro.g.z;
+    delay(6);
+  }
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    params.set((JarParamId)(PARAM_LINE_MIN_0 + i), lineSensors.calibratedMinimumOn[i]);
+    params.set((JarParamId)(PARAM_LINE_MAX_0 + i), lineSensors.calibratedMaximumOn[i]);
+  }
+  params.set(PARAM_GYRO_BIAS_Z, gyroSum / 128);
+  params.set(PARAM_CALIBRATED, 1);
+  params.save();
+  applyCalibration();
+
+  lcd.clear();
+  lcd.print(F("Saved"));
+  delay(1000);
+}
+
+// Edits the parameters: A and C change the value, B moves on to the
+// next one, and holding B for a second skips the rest. Either way the
+// parameters are then saved to EEPROM and applied. The parameters
+// can also be edited over USB serial meanwhile (send "list",
+// "set <name> <value>", "save").
+#define PARAMS_EXIT_HOLD_MS 1000
+
+void paramsDemo()
+{
+  JarParamInfo info;
+  char buf[9];
+  uint8_t id = 0;
+  bool changed = true;
+  bool bHeld = false;
+  uint16_t bPressTime = 0;
+
+  while (id < PARAM_COUNT)
+  {
+    params.poll(Serial);
+
+    switch (buttons.monitor())
+    {
+    case 'A':
+      params.step((JarParamId)id, -1);
+      changed = true;
+      break;
+    case 'C':
+      params.step((JarParamId)id, 1);
+      changed = true;
+      break;
+    case 'B':
+      id++;
+      changed = true;
+      bHeld = true;
+      bPressTime = millis();
+      break;
+    }
+
+    // Only a hold that started here counts, not the press that
+    // selected this menu item.
+    bHeld = bHeld && buttons.bIsPressed();
+    if (bHeld && (uint16_t)(millis() - bPressTime) >= PARAMS_EXIT_HOLD_MS)
+    {
+      break;
+    }
+
+    if (changed && id < PARAM_COUNT)
+    {
+      changed = false;
+      JarParams::info((JarParamId)id, &info);
+      lcd.clear();
+      lcd.print(info.name);
+      lcd.gotoXY(0, 1);
+      sprintf(buf, "%6d", params.get((JarParamId)id));
+      lcd.print(buf);
+    }
+  }
+
+  params.save();
+  configureMotorOutput();
+  configureCollision();
+  applyCalibration();
+
+  lcd.clear();
+  lcd.print(F("Saved"));
+  while (buttons.bIsPressed()) {}
+  delay(500);
+}
+
+// Finds PID gains for the wheel speed loop with a relay feedback
+// experiment: the robot spins in place while the motor command is
+// switched around a bias whenever the wheel speed crosses the
+// setpoint. The experiment is set by the Tune* parameters and any
+// button stops it. The gains are stored as MotorKp/Ki/Kd (Q8.8, per
+// AUTOTUNE_PERIOD_MS sample).
+#define AUTOTUNE_PERIOD_MS 20
+
+void autotuneDemo()
+{
+  char buf[9];
+
+  lcd.clear();
+  lcd.print(F("Autotune"));
+  lcd.gotoXY(0, 1);
+  lcd.print(F("B=start"));
+  while (buttons.monitor() != 'B') {}
+
+  lcd.clear();
+  lcd.print(F("Tuning.."));
+  lcd.gotoXY(0, 1);
+  lcd.print(F("any=stop"));
+  delay(1000);
+
+  // Setpoint in counts per sample (18 is about one wheel turn per
+  // second), bias and relay in motor effort.
+  JarAutotune tuner(params.get<PARAM_TUNE_SETPOINT>(), params.get<PARAM_TUNE_BIAS>(),
+    params.get<PARAM_TUNE_RELAY>(), params.get<PARAM_TUNE_HYSTERESIS>());
+  bool aborted = false;
+  JarEncoderSample lastEnc;
+  int16_t countsLeft, countsRight;
+  uint16_t lastSampleTime = millis();
+
+  acquireSensors(SENSE_NONE);
+  bus.encoders.read(lastEnc);
+  tuner.begin(lastSampleTime);
+  JarWatchdog::start(TASK_MOTORS, 500);
+
+  while (!tuner.done() && !tuner.failed())
+  {
+    if (buttons.monitor())
+    {
+      aborted = true;
+      break;
+    }
+    acquireSensors(SENSE_NONE);
+    if ((uint16_t)(millis() - lastSampleTime) < AUTOTUNE_PERIOD_MS) { continue; }
+    lastSampleTime += AUTOTUNE_PERIOD_MS;
+
+    encoderDeltas(lastEnc, &countsLeft, &countsRight);
+    int16_t command = tuner.update((countsRight - countsLeft) / 2, lastSampleTime);
+    motorOutput.setEfforts(-command, command);
+    JarWatchdog::checkIn(TASK_MOTORS);
+  }
+
+  motorOutput.setEfforts(0, 0);
+  JarWatchdog::stop(TASK_MOTORS);
+  reportTask(TASK_MOTORS);
+
+  lcd.clear();
+  if (aborted)
+  {
+    lcd.print(F("Stopped"));
+  }
+  else if (tuner.failed())
+  {
+    // The speed never crossed the setpoint both ways in time, or
+    // did not swing at all.
+    lcd.print(F("No"));
+    lcd.gotoXY(0, 1);
+    lcd.print(F("oscill."));
+  }
+  else
+  {
+    params.set(PARAM_MOTOR_KP, tuner.kp());
+    params.set(PARAM_MOTOR_KI, tuner.ki(AUTOTUNE_PERIOD_MS));
+    params.set(PARAM_MOTOR_KD, tuner.kd(AUTOTUNE_PERIOD_MS));
+    params.save();
+
+    sprintf(buf, "T%3u A%2u", tuner.periodMs(), tuner.amplitude());
+    lcd.print(buf);
+    lcd.gotoXY(0, 1);
+    lcd.print(F("Saved"));
+  }
+  delay(2000);
+}
+
+// Records the inputs into a trace that can be replayed on a PC.
+// A streams everything over USB serial, C stores button presses
+// and battery readings in EEPROM, B sends the trace stored in
+// EEPROM over serial. Recording goes on in the background while
+// other demos run; selecting this again stops it.
+void recordDemo()
+{
+  char buf[9];
+
+  lcd.clear();
+  if (trace.recording())
+  {
+    trace.stop();
+    lcd.print(F("Stopped"));
+    lcd.gotoXY(0, 1);
+    sprintf(buf, "lost%4u", trace.dropped);
+    lcd.print(buf);
+    delay(1000);
+    return;
+  }
+
+  lcd.print(F("A:Ser"));
+  lcd.gotoXY(0, 1);
+  lcd.print(F("B:Dm C:E"));
+
+  while (1)
+  {
+    switch (buttons.monitor())
+    {
+    case 'A':
+      trace.startSerial(Serial);
+      return;
+    case 'B':
+      JarTrace::dumpEeprom(Serial);
+      return;
+    case 'C':
+      trace.startEeprom();
+      return;
+    }
+  }
+}
+
 JarMenuItem mainMenuItems[] = {
-  { "Encoders", encoderDemo },
-  { "LEDs", ledDemo },
-  { "LineSens", lineSensorDemo },
-  { "ProxSens", proxSensorDemo },
-  { "Inertial", inertialDemo },
-  { "Motors", motorDemo },
-  { "Music", musicDemo },
-  { "Power", powerDemo },
+  { JAR_ASSET_F(MENU_ENCODERS), encoderDemo },
+  { JAR_ASSET_F(MENU_LEDS), ledDemo },
+  { JAR_ASSET_F(MENU_LINE_SENS), lineSensorDemo },
+  { JAR_ASSET_F(MENU_LINE_FAST), lineFastDemo },
+  { JAR_ASSET_F(MENU_PROX_SENS), proxSensorDemo },
+  { JAR_ASSET_F(MENU_PROX_MAP), proxMapDemo },
+  { JAR_ASSET_F(MENU_INERTIAL), inertialDemo },
+  { JAR_ASSET_F(MENU_IMPACTS), impactDemo },
+  { JAR_ASSET_F(MENU_MOTORS), motorDemo },
+  { JAR_ASSET_F(MENU_AUTOTUNE), autotuneDemo },
+  { JAR_ASSET_F(MENU_MUSIC), musicDemo },
+  { JAR_ASSET_F(MENU_POWER), powerDemo },
+  { JAR_ASSET_F(MENU_CALIB), calibrateDemo },
+  { JAR_ASSET_F(MENU_PARAMS), paramsDemo },
+  { JAR_ASSET_F(MENU_RECORD), recordDemo },
 };
-JarMenu mainMenu(mainMenuItems, 8, &lcd);
+JarMenu<Zumo32U4LCD, TracedButtons> mainMenu(mainMenuItems,
+  sizeof(mainMenuItems) / sizeof(mainMenuItems[0]), lcd, buttons);
 
 void setup()
 {
+  JarWatchdog::begin(stopMotors);
+  params.load();
+  configureMotorOutput();
+
   lineSensors.initThreeSensors();
+  static const uint8_t lineFastPins[] = { SENSOR_DOWN1, SENSOR_DOWN3, SENSOR_DOWN5 };
+  lineFast.begin(lineFastPins, SENSOR_LEDON);
   proxSensors.initThreeSensors();
   initInertialSensors();
+  applyCalibration();
+  acquireSensors(SENSE_ALL);
 
   loadCustomCharacters();
 
@@ -654,16 +981,32 @@ void setup()
     // (VCC dropped below 4.3 V).
     // Play a special sound and display a note to the user.
 
-    jb.buzzer.playFromProgramSpace(beepBrownout);
+    jb.buzzer.playFromProgramSpace(JAR_ASSET(BEEP_BROWNOUT));
     lcd.clear();
     lcd.print(F("Brownout"));
     lcd.gotoXY(0, 1);
     lcd.print(F(" reset! "));
     delay(1000);
   }
+  else if (JarWatchdog::lastReset.reason == WATCHDOG_REASON_DEADLINE)
+  {
+    // A supervised task missed its deadline; the watchdog stopped
+    // the motors and reset the board. Show which task it was and
+    // how late it was.
+    char buf[9];
+
+    jb.buzzer.playFromProgramSpace(JAR_ASSET(BEEP_BROWNOUT));
+    lcd.clear();
+    lcd.print(F("Deadline"));
+    lcd.gotoXY(0, 1);
+    sprintf(buf, "T%u %4u", JarWatchdog::lastReset.task,
+      JarWatchdog::lastReset.lateMs);
+    lcd.print(buf);
+    delay(1000);
+  }
   else
   {
-    jb.buzzer.playFromProgramSpace(beepWelcome);
+    jb.buzzer.playFromProgramSpace(JAR_ASSET(BEEP_WELCOME));
   }
 
   lcd.clear();
@@ -692,7 +1035,7 @@ void setup()
 
   // while (jb.monitor() != 'B'){}
 
-  // jb.buzzer.playFromProgramSpace(beepThankYou);
+  // jb.buzzer.playFromProgramSpace(JAR_ASSET(BEEP_THANK_YOU));
   // lcd.clear();
   // lcd.print(F(" Thank"));
   // lcd.gotoXY(0, 1);
@@ -0,0 +1,142 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// In-memory stand-in for the parts of the Arduino core the Jar
+// libraries use, so they build in the native environment. Time only
+// moves when a test advances it (or calls delay()), which is what
+// lets a trace replay run faster than real time.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+
+// Program space is ordinary memory on the host.
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strcasecmp_P strcasecmp
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+// Functions rather than the AVR core's macros, so they do not clash
+// with the C++ standard headers a test may include.
+template <class A, class B>
+inline auto min(A a, B b) -> decltype(a < b ? a : b) { return a < b ? a : b; }
+template <class A, class B>
+inline auto max(A a, B b) -> decltype(a > b ? a : b) { return a > b ? a : b; }
+template <class T, class L, class H>
+inline T constrain(T x, L low, H high) { return x < low ? low : (x > high ? high : x); }
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// The simulated clock, in microseconds.
+namespace JarHost
+{
+  inline uint32_t &clock()
+  {
+    static uint32_t now;
+    return now;
+  }
+  inline void advanceMicros(uint32_t us) { clock() += us; }
+  inline void advanceMillis(uint32_t ms) { clock() += ms * 1000; }
+
+  // Called on every micros() and delayMicroseconds(), so a test can
+  // simulate hardware that changes within a busy-wait: advance the
+  // clock and update the port registers below.
+  typedef void (*TimeHook)();
+  inline TimeHook &timeHook()
+  {
+    static TimeHook hook;
+    return hook;
+  }
+
+  // Simulated I/O ports. Pin n is bit n % 8 of port n / 8.
+  inline volatile uint8_t *pinRegisters() { static volatile uint8_t regs[4]; return regs; }
+  inline volatile uint8_t *ddrRegisters() { static volatile uint8_t regs[4]; return regs; }
+  inline volatile uint8_t *portRegisters() { static volatile uint8_t regs[4]; return regs; }
+  inline volatile uint8_t &statusRegister() { static volatile uint8_t reg; return reg; }
+}
+
+inline unsigned long micros()
+{
+  if (JarHost::timeHook()) { JarHost::timeHook()(); }
+  return JarHost::clock();
+}
+inline unsigned long millis() { return JarHost::clock() / 1000; }
+inline void delay(unsigned long ms) { JarHost::advanceMillis(ms); }
+inline void delayMicroseconds(unsigned int us)
+{
+  JarHost::advanceMicros(us);
+  if (JarHost::timeHook()) { JarHost::timeHook()(); }
+}
+
+#define noInterrupts()
+#define interrupts()
+#define SREG (JarHost::statusRegister())
+
+#define digitalPinToPort(pin) ((pin) / 8)
+#define digitalPinToBitMask(pin) (1 << ((pin) % 8))
+#define portInputRegister(port) (&JarHost::pinRegisters()[port])
+#define portModeRegister(port) (&JarHost::ddrRegisters()[port])
+#define portOutputRegister(port) (&JarHost::portRegisters()[port])
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+
+  size_t print(const char *s)
+  {
+    size_t n = 0;
+    while (*s) { n += write(*s++); }
+    return n;
+  }
+  size_t print(const __FlashStringHelper *s) { return print((const char *)s); }
+  size_t print(char c) { return write(c); }
+  size_t print(long x)
+  {
+    char buf[12];
+    snprintf(buf, sizeof(buf), "%ld", x);
+    return print(buf);
+  }
+  size_t print(int x) { return print((long)x); }
+  size_t print(unsigned int x) { return print((long)x); }
+  size_t print(unsigned long x) { return print((long)x); }
+  size_t println() { return print("\r\n"); }
+  template <class T>
+  size_t println(T x)
+  {
+    size_t n = print(x);
+    return n + println();
+  }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+// The 1 KB EEPROM of the ATmega32U4, kept in memory. Writes are
+// immediate, so the EEPROM is always ready.
+
+#include <stdint.h>
+#include <string.h>
+
+#define E2END 0x3FF
+
+namespace JarHost
+{
+  inline uint8_t *eeprom()
+  {
+    static uint8_t bytes[E2END + 1];
+    return bytes;
+  }
+}
+
+#define eeprom_is_ready() 1
+#define eeprom_busy_wait()
+
+inline uint8_t eeprom_read_byte(const uint8_t *p) { return JarHost::eeprom()[(uintptr_t)p]; }
+inline void eeprom_write_byte(uint8_t *p, uint8_t b) { JarHost::eeprom()[(uintptr_t)p] = b; }
+inline void eeprom_update_byte(uint8_t *p, uint8_t b) { eeprom_write_byte(p, b); }
+
+inline uint16_t eeprom_read_word(const uint16_t *p)
+{
+  uint16_t w;
+  memcpy(&w, JarHost::eeprom() + (uintptr_t)p, 2);
+  return w;
+}
+inline void eeprom_update_word(uint16_t *p, uint16_t w)
+{
+  memcpy(JarHost::eeprom() + (uintptr_t)p, &w, 2);
+}
+
+inline void eeprom_read_block(void *dst, const void *src, size_t n)
+{
+  memcpy(dst, JarHost::eeprom() + (uintptr_t)src, n);
+}
+inline void eeprom_update_block(const void *src, void *dst, size_t n)
+{
+  memcpy(JarHost::eeprom() + (uintptr_t)dst, src, n);
+}
+
+#endif
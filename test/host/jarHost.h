@@ -0,0 +1,122 @@
+#ifndef HOST_JAR_H
+#define HOST_JAR_H
+
+#include <Arduino.h>
+
+// In-memory stand-ins for the Zumo hardware classes that the Jar
+// templates are instantiated with on the robot.
+
+// An 8x2 character LCD like Zumo32U4LCD.
+class HostLcd : public Print
+{
+public:
+  HostLcd() { clear(); }
+
+  void clear()
+  {
+    memset(screen, ' ', sizeof(screen));
+    for (uint8_t y = 0; y < 2; y++) { screen[y][8] = 0; }
+    x = y = 0;
+  }
+
+  void gotoXY(uint8_t x, uint8_t y)
+  {
+    this->x = x;
+    this->y = y;
+  }
+
+  size_t write(uint8_t c)
+  {
+    if (x < 8 && y < 2) { screen[y][x] = c; }
+    x++;
+    return 1;
+  }
+
+  const char *line(uint8_t y) const { return screen[y]; }
+
+private:
+  char screen[2][9];
+  uint8_t x, y;
+};
+
+// A push button like Zumo32U4ButtonA. Tests press and release it.
+class HostButton
+{
+public:
+  HostButton() : pressed(false), pending(false) {}
+
+  void press()
+  {
+    if (!pressed) { pending = true; }
+    pressed = true;
+  }
+  void release() { pressed = false; }
+
+  bool isPressed() { return pressed; }
+  bool getSingleDebouncedPress()
+  {
+    bool result = pending;
+    pending = false;
+    return result;
+  }
+
+private:
+  bool pressed;
+  bool pending;
+};
+
+// A buzzer like Zumo32U4Buzzer that remembers what it last played.
+class HostBuzzer
+{
+public:
+  HostBuzzer() : last(0), count(0) {}
+
+  void play(const char *notes)
+  {
+    last = notes;
+    count++;
+  }
+  void playFromProgramSpace(const char *notes) { play(notes); }
+  bool isPlaying() { return false; }
+
+  const char *last;
+  uint16_t count;
+};
+
+// Motors like Zumo32U4Motors that keep the last speeds set.
+class HostMotors
+{
+public:
+  HostMotors() : left(0), right(0) {}
+
+  void setSpeeds(int16_t left, int16_t right)
+  {
+    this->left = left;
+    this->right = right;
+  }
+
+  int16_t left, right;
+};
+
+// A serial port: what is written is kept in out, what is to be read
+// comes from in.
+class HostStream : public Stream
+{
+public:
+  HostStream() : in(""), outLength(0) {}
+
+  size_t write(uint8_t b)
+  {
+    if (outLength >= sizeof(out)) { return 0; }
+    out[outLength++] = b;
+    return 1;
+  }
+  int available() { return strlen(in); }
+  int read() { return *in ? *in++ : -1; }
+
+  const char *in;
+  uint8_t out[65536];
+  uint32_t outLength;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef HOST_REPLAY_H
+#define HOST_REPLAY_H
+
+#include <Arduino.h>
+#include <jarTrace.h>
+
+// Plays a recorded trace back on the host, for running firmware loops
+// against what the robot saw.
+//
+// It has the button interface of JarTracedButtons, so a loop runs on
+// it unchanged. Each monitor() call is one millisecond of the
+// recording: it moves the simulated clock on by a millisecond and
+// applies every record of that millisecond. Sensor samples are
+// published on the bus, held buttons answer the xIsPressed() queries,
+// and a button press is returned. Loops that act on elapsed time, like
+// the motor panel, so see the same clock as they did live. At the end
+// of the trace monitor() returns 'B', so every loop that waits for B
+// finishes.
+class JarReplay
+{
+public:
+  JarReplay(const uint8_t *data, uint32_t length, JarBus &bus)
+    : ticks(0), records(0), reader(data, length), bus(bus), held(0), finished(false)
+  {
+    pending.type = TRACE_TIME;
+    pendingValid = false;
+    if (fetch()) { time = pending.time - 1; }
+  }
+
+  bool valid() const { return reader.valid(); }
+  bool done() const { return finished; }
+
+  char monitor()
+  {
+    if (!fetch())
+    {
+      finished = true;
+      return 'B';
+    }
+
+    // Record times are 16 bits, like millis() on the robot.
+    time++;
+    JarHost::advanceMillis(1);
+    ticks++;
+
+    char button = 0;
+    while (fetch() && pending.time == time)
+    {
+      pendingValid = false;
+      records++;
+      if (pending.type == TRACE_BUTTON)
+      {
+        button = pending.button;
+      }
+      else if (pending.type == TRACE_HELD)
+      {
+        held = pending.held;
+      }
+      else
+      {
+        JarTraceReader::publish(pending, bus);
+      }
+    }
+    return button;
+  }
+
+  bool aIsPressed() { return held & TRACE_HELD_A; }
+  bool bIsPressed() { return held & TRACE_HELD_B; }
+  bool cIsPressed() { return held & TRACE_HELD_C; }
+
+  // Milliseconds replayed, and the records in them.
+  uint32_t ticks;
+  uint32_t records;
+
+private:
+  bool fetch()
+  {
+    if (!pendingValid)
+    {
+      pendingValid = reader.next(pending);
+    }
+    return pendingValid;
+  }
+
+  JarTraceReader reader;
+  JarBus &bus;
+  JarTraceRecord pending;
+  bool pendingValid;
+  uint8_t held;
+  uint16_t time;
+  bool finished;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef HOST_CRC16_H
+#define HOST_CRC16_H
+
+#include <stdint.h>
+
+// Same polynomial (0xA001) as avr-libc's _crc16_update().
+inline uint16_t _crc16_update(uint16_t crc, uint8_t a)
+{
+  crc ^= a;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+  }
+  return crc;
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include <unity.h>
+#include <jarAutotune.h>
+#include <math.h>
+
+// Runs the relay experiment against a simulated motor: a first-order
+// lag with time constant TAU_MS and gain GAIN (speed units per unit
+// of command) behind a dead time of DELAY_MS. For this model the
+// relay oscillation is known exactly, so the identified period and
+// amplitude can be checked, and through them Ku and the gains.
+#define TAU_MS 100.0
+#define DELAY_MS 40
+#define GAIN 4.0
+
+#define SETPOINT 600
+#define BIAS 150
+#define RELAY 60
+
+struct Motor
+{
+  double speed;
+  int16_t commands[DELAY_MS];
+  uint8_t index;
+
+  // Starts at rest at the speed the bias holds.
+  void reset()
+  {
+    speed = GAIN * BIAS;
+    for (uint8_t i = 0; i < DELAY_MS; i++) { commands[i] = BIAS; }
+    index = 0;
+  }
+
+  // Applies a command for 1 ms; it reaches the motor DELAY_MS later.
+  void step(int16_t command)
+  {
+    int16_t delayed = commands[index];
+    commands[index] = command;
+    index = (index + 1) % DELAY_MS;
+    speed += (GAIN * delayed - speed) * (1 - exp(-1 / TAU_MS));
+  }
+};
+
+static Motor motor;
+
+// Feeds the tuner every samplePeriodMs until it finishes. Returns
+// false if it did not finish within a minute.
+static bool runTuner(JarAutotune &tuner, uint16_t samplePeriodMs)
+{
+  uint16_t now = 1000;
+  int16_t command = BIAS;
+  tuner.begin(now);
+  for (uint16_t i = 0; i < 60000; i++)
+  {
+    if (i % samplePeriodMs == 0)
+    {
+      command = tuner.update(lround(motor.speed), now);
+      if (tuner.done() || tuner.failed()) { return true; }
+    }
+    motor.step(command);
+    now++;
+  }
+  return false;
+}
+
+// The relay oscillation of the model: the speed overshoots for the
+// dead time after each switch, then decays towards the other relay
+// level until it crosses the setpoint again. Sampled every ms, the
+// tuner sees a crossing up to a sample late, which adds to the dead
+// time.
+#define SWITCH_LAG_MS 1
+
+static double relayAmplitude()
+{
+  return GAIN * RELAY * (1 - exp(-(DELAY_MS + SWITCH_LAG_MS) / TAU_MS));
+}
+
+static double relayPeriodMs()
+{
+  double delay = DELAY_MS + SWITCH_LAG_MS;
+  return 2 * (delay + TAU_MS * log(2 - exp(-delay / TAU_MS)));
+}
+
+void setUp()
+{
+  motor.reset();
+}
+
+void tearDown() {}
+
+void test_identifies_relay_oscillation()
+{
+  JarAutotune tuner(SETPOINT, BIAS, RELAY, 0);
+  TEST_ASSERT_TRUE(runTuner(tuner, 1));
+  TEST_ASSERT_TRUE(tuner.done());
+
+  // The speed is rounded, and crossings fall between samples.
+  TEST_ASSERT_FLOAT_WITHIN(2, relayPeriodMs(), tuner.periodMs());
+  TEST_ASSERT_FLOAT_WITHIN(2, relayAmplitude(), tuner.amplitude());
+
+  double ku = 4 * RELAY / (M_PI * relayAmplitude());
+  TEST_ASSERT_FLOAT_WITHIN(ku * 0.03, ku, tuner.ultimateGain() / 256.0);
+}
+
+// The relay finds the ultimate point only approximately (it assumes
+// the oscillation is a sine); for this plant Tu is within 10% and
+// Ku within 25% of the values from the frequency response.
+void test_close_to_ultimate_point()
+{
+  // The phase lag of the model, atan(w tau) + w delay, reaches pi at
+  // the ultimate frequency.
+  double low = 0, high = M_PI / DELAY_MS;
+  for (uint8_t i = 0; i < 50; i++)
+  {
+    double w = (low + high) / 2;
+    if (atan(w * TAU_MS) + w * DELAY_MS < M_PI) { low = w; }
+    else { high = w; }
+  }
+  double tu = 2 * M_PI / low;
+  double ku = sqrt(1 + low * TAU_MS * low * TAU_MS) / GAIN;
+
+  JarAutotune tuner(SETPOINT, BIAS, RELAY, 0);
+  TEST_ASSERT_TRUE(runTuner(tuner, 1));
+  TEST_ASSERT_TRUE(tuner.done());
+  TEST_ASSERT_FLOAT_WITHIN(tu * 0.1, tu, tuner.periodMs());
+  TEST_ASSERT_FLOAT_WITHIN(ku * 0.25, ku, tuner.ultimateGain() / 256.0);
+}
+
+// Sampled like the firmware, the switching lags by up to a sample,
+// which lengthens the period; hysteresis does the same.
+void test_sampled_with_hysteresis()
+{
+  JarAutotune tuner(SETPOINT, BIAS, RELAY, 5);
+  TEST_ASSERT_TRUE(runTuner(tuner, 10));
+  TEST_ASSERT_TRUE(tuner.done());
+  TEST_ASSERT_GREATER_OR_EQUAL(relayPeriodMs(), tuner.periodMs());
+  TEST_ASSERT_LESS_OR_EQUAL(relayPeriodMs() + 4 * 10, tuner.periodMs());
+}
+
+void test_gains_follow_ziegler_nichols()
+{
+  const uint16_t samplePeriodMs = 20;
+  JarAutotune tuner(SETPOINT, BIAS, RELAY, 0);
+  TEST_ASSERT_TRUE(runTuner(tuner, 1));
+  TEST_ASSERT_TRUE(tuner.done());
+
+  double ku = tuner.ultimateGain() / 256.0;
+  double tu = tuner.periodMs();
+  double kp = 0.6 * ku;
+  TEST_ASSERT_FLOAT_WITHIN(1.5 / 256, kp, tuner.kp() / 256.0);
+  // Ki = Kp / Ti per sample, Ti = Tu / 2; Kd = Kp Td per sample,
+  // Td = Tu / 8.
+  TEST_ASSERT_FLOAT_WITHIN(1.5 / 256, kp * samplePeriodMs / (tu / 2), tuner.ki(samplePeriodMs) / 256.0);
+  TEST_ASSERT_FLOAT_WITHIN(kp * tu / 8 / samplePeriodMs * 0.02 + 1.5 / 256,
+                           kp * tu / 8 / samplePeriodMs, tuner.kd(samplePeriodMs) / 256.0);
+}
+
+// The firmware measures about 18 encoder counts per sample, so the
+// swing is a few counts and odd more often than not. A swing of 5
+// is an amplitude of 2.5, not 2.
+void test_low_resolution_amplitude()
+{
+  static const int16_t counts[] = {18, 20, 21, 20, 18, 17, 16, 17};
+  const uint16_t samplePeriodMs = 20;
+  JarAutotune tuner(18, BIAS, RELAY, 1);
+  uint16_t now = 1000;
+  tuner.begin(now);
+  for (uint16_t i = 0; i < 200 && !tuner.done() && !tuner.failed(); i++)
+  {
+    tuner.update(counts[i % 8], now);
+    now += samplePeriodMs;
+  }
+  TEST_ASSERT_TRUE(tuner.done());
+  TEST_ASSERT_EQUAL_UINT16(8 * samplePeriodMs, tuner.periodMs());
+  TEST_ASSERT_EQUAL_UINT16(3, tuner.amplitude());
+
+  double ku = 4 * RELAY / (M_PI * 2.5);
+  TEST_ASSERT_FLOAT_WITHIN(ku * 0.01, ku, tuner.ultimateGain() / 256.0);
+}
+
+void test_fails_without_oscillation()
+{
+  // The relay cannot reach a setpoint this far above the bias.
+  JarAutotune tuner(SETPOINT * 2, BIAS, RELAY, 0);
+  TEST_ASSERT_TRUE(runTuner(tuner, 1));
+  TEST_ASSERT_TRUE(tuner.failed());
+  TEST_ASSERT_EQUAL_INT16(0, tuner.update(0, 0));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_identifies_relay_oscillation);
+  RUN_TEST(test_close_to_ultimate_point);
+  RUN_TEST(test_sampled_with_hysteresis);
+  RUN_TEST(test_gains_follow_ziegler_nichols);
+  RUN_TEST(test_low_resolution_amplitude);
+  RUN_TEST(test_fails_without_oscillation);
+  return UNITY_END();
+}
@@ -0,0 +1,276 @@
+#include <unity.h>
+#include <jarBus.h>
+#include <new>
+#include <signal.h>
+#include <sys/time.h>
+
+// A timer signal stands in for an interrupt: it stops the main
+// program at an arbitrary instruction, runs to completion and
+// returns, just like an ISR on the single-core AVR. Either side of a
+// slot or stream runs in the handler while the other side runs in a
+// tight loop, and every sample that comes out must be one that was
+// put in whole.
+
+#define SIGNAL_PERIOD_US 20
+#define SIGNALS_PER_TEST 4000
+#define MAX_LOOPS 200000000UL
+
+// Large enough that a publish takes a while and is often interrupted.
+struct BigSample
+{
+  uint32_t n;
+  uint32_t copies[31];
+};
+
+static void fill(BigSample &sample, uint32_t n)
+{
+  sample.n = n;
+  for (uint8_t i = 0; i < 31; i++) { sample.copies[i] = n * 2654435761u + i; }
+}
+
+static bool whole(const BigSample &sample)
+{
+  for (uint8_t i = 0; i < 31; i++)
+  {
+    if (sample.copies[i] != sample.n * 2654435761u + i) { return false; }
+  }
+  return true;
+}
+
+static JarSlot<BigSample> slot;
+static JarStream<BigSample, 8> stream;
+static void (*handler)();
+static volatile uint32_t signals, reads, torn, midPublish, nextN, lastN, outOfOrder;
+
+static void onSignal(int)
+{
+  signals++;
+  handler();
+}
+
+static void startInterrupts(void (*isr)())
+{
+  handler = isr;
+  signals = reads = torn = midPublish = nextN = lastN = outOfOrder = 0;
+  signal(SIGALRM, onSignal);
+  struct itimerval timer = { { 0, SIGNAL_PERIOD_US }, { 0, SIGNAL_PERIOD_US } };
+  setitimer(ITIMER_REAL, &timer, 0);
+}
+
+static void stopInterrupts()
+{
+  struct itimerval timer = { { 0, 0 }, { 0, 0 } };
+  setitimer(ITIMER_REAL, &timer, 0);
+  signal(SIGALRM, SIG_DFL);
+}
+
+static void report(const char *name)
+{
+  char message[96];
+  snprintf(message, sizeof(message), "%s: %u interrupts, %u reads, %u mid-publish",
+           name, (unsigned)signals, (unsigned)reads, (unsigned)midPublish);
+  TEST_MESSAGE(message);
+}
+
+void setUp()
+{
+  new (&slot) JarSlot<BigSample>();
+  new (&stream) JarStream<BigSample, 8>();
+}
+void tearDown() {}
+
+void test_slot_empty_until_published()
+{
+  BigSample sample;
+  TEST_ASSERT_FALSE(slot.read(sample));
+  fill(sample, 1);
+  slot.publish(sample);
+  TEST_ASSERT_TRUE(slot.read(sample));
+  TEST_ASSERT_EQUAL(1, sample.n);
+}
+
+// The 8-bit sequence wraps every 128 publishes; a valid sample must
+// still read as valid then.
+void test_slot_read_across_wrap()
+{
+  uint8_t lastSeq = slot.sequence();
+  for (uint16_t n = 1; n <= 1000; n++)
+  {
+    BigSample sample;
+    fill(sample, n);
+    slot.publish(sample);
+    TEST_ASSERT_NOT_EQUAL(lastSeq, slot.sequence());
+    lastSeq = slot.sequence();
+    TEST_ASSERT_TRUE(slot.read(sample));
+    TEST_ASSERT_EQUAL(n, sample.n);
+  }
+}
+
+static void slotReaderIsr()
+{
+  BigSample sample;
+  if (slot.sequence() & 1) { midPublish++; }
+  if (slot.read(sample))
+  {
+    reads++;
+    if (!whole(sample)) { torn++; }
+  }
+}
+
+// A reader in an interrupt that preempts the producer halfway
+// through publish() gives up instead of returning a mixed sample.
+void test_slot_reader_preempts_producer()
+{
+  BigSample sample;
+  startInterrupts(slotReaderIsr);
+  for (uint32_t n = 0; signals < SIGNALS_PER_TEST && n < MAX_LOOPS; n++)
+  {
+    fill(sample, n);
+    slot.publish(sample);
+  }
+  stopInterrupts();
+  report("slot reader in ISR");
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_GREATER_THAN(0, midPublish);
+  TEST_ASSERT_GREATER_THAN(0, reads);
+}
+
+static void slotProducerIsr()
+{
+  BigSample sample;
+  fill(sample, ++nextN);
+  slot.publish(sample);
+}
+
+// A producer in an interrupt that preempts a reader halfway through
+// read() makes the reader retry.
+void test_slot_producer_preempts_reader()
+{
+  BigSample sample;
+  startInterrupts(slotProducerIsr);
+  for (uint32_t i = 0; signals < SIGNALS_PER_TEST && i < MAX_LOOPS; i++)
+  {
+    if (slot.read(sample))
+    {
+      reads++;
+      if (!whole(sample)) { torn++; }
+      if (sample.n < lastN) { outOfOrder++; }
+      lastN = sample.n;
+    }
+  }
+  stopInterrupts();
+  report("slot producer in ISR");
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_EQUAL(0, outOfOrder);
+  TEST_ASSERT_GREATER_THAN(0, reads);
+}
+
+static void streamProducerIsr()
+{
+  BigSample sample;
+  fill(sample, ++nextN);
+  stream.publish(sample);
+}
+
+// A reader of a stream that is overtaken by the producer skips ahead
+// and counts what it lost, but never returns a mixed sample or one
+// out of order.
+void test_stream_producer_preempts_reader()
+{
+  JarStream<BigSample, 8>::Reader reader(stream);
+  BigSample sample;
+  uint32_t lost = 0;
+  startInterrupts(streamProducerIsr);
+  for (uint32_t i = 0; signals < SIGNALS_PER_TEST && i < MAX_LOOPS; i++)
+  {
+    uint16_t lostBefore = reader.lost;
+    if (reader.next(sample))
+    {
+      reads++;
+      lost += reader.lost - lostBefore;
+      if (!whole(sample)) { torn++; }
+      if (sample.n <= lastN) { outOfOrder++; }
+      lastN = sample.n;
+    }
+  }
+  stopInterrupts();
+  while (reader.next(sample))
+  {
+    reads++;
+    if (!whole(sample)) { torn++; }
+  }
+  report("stream producer in ISR");
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_EQUAL(0, outOfOrder);
+  TEST_ASSERT_GREATER_THAN(0, reads);
+  TEST_ASSERT_LESS_OR_EQUAL(nextN, reads + lost);
+}
+
+// A slow reader loses more than 255 samples over time; the count
+// keeps growing and then stays at its maximum.
+void test_stream_lost_count_does_not_wrap()
+{
+  JarStream<BigSample, 8>::Reader reader(stream);
+  BigSample sample;
+  for (uint32_t round = 1; round <= 30000; round++)
+  {
+    for (uint8_t i = 0; i < 10; i++)
+    {
+      fill(sample, i);
+      stream.publish(sample);
+    }
+    while (reader.next(sample)) {}
+    if (round == 100)
+    {
+      TEST_ASSERT_EQUAL_UINT16(300, reader.lost);
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT16(0xFFFF, reader.lost);
+}
+
+static JarStream<BigSample, 8>::Reader *isrReader;
+
+static void streamReaderIsr()
+{
+  BigSample sample;
+  while (isrReader->next(sample))
+  {
+    reads++;
+    if (!whole(sample)) { torn++; }
+    if (sample.n <= lastN) { outOfOrder++; }
+    lastN = sample.n;
+  }
+}
+
+// A stream reader in an interrupt only sees samples whose publish
+// has finished.
+void test_stream_reader_preempts_producer()
+{
+  JarStream<BigSample, 8>::Reader reader(stream);
+  isrReader = &reader;
+  BigSample sample;
+  startInterrupts(streamReaderIsr);
+  for (uint32_t n = 1; signals < SIGNALS_PER_TEST && n < MAX_LOOPS; n++)
+  {
+    fill(sample, n);
+    stream.publish(sample);
+  }
+  stopInterrupts();
+  report("stream reader in ISR");
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_EQUAL(0, outOfOrder);
+  TEST_ASSERT_GREATER_THAN(0, reads);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_slot_empty_until_published);
+  RUN_TEST(test_slot_read_across_wrap);
+  RUN_TEST(test_slot_reader_preempts_producer);
+  RUN_TEST(test_slot_producer_preempts_reader);
+  RUN_TEST(test_stream_producer_preempts_reader);
+  RUN_TEST(test_stream_lost_count_does_not_wrap);
+  RUN_TEST(test_stream_reader_preempts_producer);
+  return UNITY_END();
+}
@@ -0,0 +1,191 @@
+#include <unity.h>
+#include <jarCollision.h>
+
+// Register-level stand-in for the LSM303 driver. Reading an event
+// source register clears it, like the latched registers do; readAcc()
+// pops the FIFO.
+struct FakeImu
+{
+  uint8_t regs[0x40];
+  struct { int16_t x, y, z; } a;
+  int16_t fifo[32][3];
+  uint8_t fifoCount, fifoRead;
+  uint8_t accReads;
+
+  void reset()
+  {
+    memset(regs, 0, sizeof(regs));
+    fifoCount = fifoRead = 0;
+    accReads = 0;
+  }
+
+  void writeReg(uint8_t reg, uint8_t value) { regs[reg] = value; }
+
+  uint8_t readReg(uint8_t reg)
+  {
+    uint8_t value = regs[reg];
+    if (reg == LSM303D_CLICK_SRC || reg == LSM303D_IG_SRC1) { regs[reg] = 0; }
+    if (reg == LSM303D_FIFO_SRC) { value = fifoCount - fifoRead; }
+    return value;
+  }
+
+  void readAcc()
+  {
+    accReads++;
+    uint8_t i = fifoRead < fifoCount ? fifoRead++ : fifoCount - 1;
+    a.x = fifo[i][0];
+    a.y = fifo[i][1];
+    a.z = fifo[i][2];
+  }
+};
+
+static FakeImu imu;
+static JarCollision<FakeImu> *collision;
+static JarStream<JarImpactEvent, 8> *impacts;
+static JarStream<JarImpactEvent, 8>::Reader *reader;
+
+void setUp()
+{
+  static JarCollision<FakeImu> collisionStorage(imu);
+  static JarStream<JarImpactEvent, 8> impactStorage;
+  static JarStream<JarImpactEvent, 8>::Reader readerStorage(impactStorage);
+  imu.reset();
+  collision = &collisionStorage;
+  impacts = &impactStorage;
+  reader = &readerStorage;
+  JarImpactEvent old;
+  while (reader->next(old)) {}
+  collision->begin(500, 1500);
+}
+
+void tearDown() {}
+
+void test_filters_gravity_out()
+{
+  TEST_ASSERT_EQUAL_HEX8(COLLISION_CTRL0_HP, imu.regs[LSM303D_CTRL0] & 0x46);
+  TEST_ASSERT_EQUAL_UINT8(500 / 31, imu.regs[LSM303D_CLICK_THS]);
+  TEST_ASSERT_EQUAL_UINT8(1500 / 31, imu.regs[LSM303D_IG_THS1]);
+}
+
+void test_begin_again_applies_new_thresholds()
+{
+  collision->begin(1000, 2000, true);
+  TEST_ASSERT_EQUAL_UINT8(1000 / 31, imu.regs[LSM303D_CLICK_THS]);
+  TEST_ASSERT_EQUAL_UINT8(2000 / 31, imu.regs[LSM303D_IG_THS1]);
+  TEST_ASSERT_EQUAL_HEX8(0x46, imu.regs[LSM303D_CTRL0] & 0x46);
+
+  collision->begin(1000, 2000);
+  TEST_ASSERT_EQUAL_HEX8(COLLISION_CTRL0_HP, imu.regs[LSM303D_CTRL0] & 0x46);
+  TEST_ASSERT_EQUAL_HEX8(0, imu.regs[LSM303D_FIFO_CTRL]);
+}
+
+void test_nothing_without_event()
+{
+  TEST_ASSERT_FALSE(collision->poll(*impacts));
+  JarImpactEvent event;
+  TEST_ASSERT_FALSE(reader->next(event));
+}
+
+void test_click_direction_from_sign_bits()
+{
+  // Negative X: a bump from the front pushes the robot backwards.
+  imu.regs[LSM303D_CLICK_SRC] = 0x40 | 0x08 | 0x01;
+  TEST_ASSERT_TRUE(collision->poll(*impacts));
+
+  JarImpactEvent event;
+  TEST_ASSERT_TRUE(reader->next(event));
+  TEST_ASSERT_EQUAL_UINT8(IMPACT_CLICK | IMPACT_AT_LEAST, event.source);
+  TEST_ASSERT_EQUAL_UINT8(128, event.direction);
+  TEST_ASSERT_EQUAL_UINT16(500 / 31 * 31, event.magnitude);
+
+  // Positive X and Y together.
+  imu.regs[LSM303D_CLICK_SRC] = 0x40 | 0x02 | 0x01;
+  TEST_ASSERT_TRUE(collision->poll(*impacts));
+  TEST_ASSERT_TRUE(reader->next(event));
+  TEST_ASSERT_EQUAL_UINT8(32, event.direction);
+
+  // Nothing is read from the output registers, which only hold a
+  // sample from after the bump.
+  TEST_ASSERT_EQUAL_UINT8(0, imu.accReads);
+}
+
+void test_threshold_uses_click_sign()
+{
+  imu.regs[LSM303D_CLICK_SRC] = 0x40 | 0x08 | 0x02;
+  imu.regs[LSM303D_IG_SRC1] = 0x40 | 0x08;
+  TEST_ASSERT_TRUE(collision->poll(*impacts));
+
+  JarImpactEvent event;
+  TEST_ASSERT_TRUE(reader->next(event));
+  TEST_ASSERT_EQUAL_UINT8(IMPACT_CLICK | IMPACT_THRESHOLD | IMPACT_AT_LEAST, event.source);
+  TEST_ASSERT_EQUAL_UINT8(192, event.direction);
+  TEST_ASSERT_EQUAL_UINT16(1500 / 31 * 31, event.magnitude);
+}
+
+void test_threshold_alone_is_unsigned()
+{
+  imu.regs[LSM303D_IG_SRC1] = 0x40 | 0x08;
+  TEST_ASSERT_TRUE(collision->poll(*impacts));
+
+  JarImpactEvent event;
+  TEST_ASSERT_TRUE(reader->next(event));
+  TEST_ASSERT_EQUAL_UINT8(IMPACT_THRESHOLD | IMPACT_UNSIGNED | IMPACT_AT_LEAST, event.source);
+  TEST_ASSERT_EQUAL_UINT8(64, event.direction);
+}
+
+void test_fifo_reports_peak()
+{
+  collision->begin(500, 1500, true);
+  static const int16_t samples[3][3] = {{800, 0, 8000}, {-16000, 800, 8000}, {-4000, 0, 8000}};
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    memcpy(imu.fifo[i], samples[i], sizeof(samples[i]));
+  }
+  imu.fifoCount = 3;
+  const int16_t gravity[3] = {0, 0, 8000};
+  for (uint8_t i = 0; i < 100; i++) { collision->updateBaseline(gravity); }
+
+  imu.regs[LSM303D_CLICK_SRC] = 0x40 | 0x08 | 0x01;
+  TEST_ASSERT_TRUE(collision->poll(*impacts));
+
+  JarImpactEvent event;
+  TEST_ASSERT_TRUE(reader->next(event));
+  TEST_ASSERT_EQUAL_UINT8(3, imu.accReads);
+  TEST_ASSERT_EQUAL_UINT8(IMPACT_CLICK, event.source);
+  TEST_ASSERT_UINT16_WITHIN(2, 2002, event.magnitude);
+  TEST_ASSERT_UINT8_WITHIN(1, 126, event.direction);
+}
+
+// Full scale the other way from a tilted baseline: 48000 counts
+// apart, more than an int16_t holds.
+void test_fifo_peak_beyond_16_bits()
+{
+  collision->begin(500, 1500, true);
+  const int16_t tilted[3] = {16000, 0, 0};
+  for (uint8_t i = 0; i < 200; i++) { collision->updateBaseline(tilted); }
+  const int16_t hit[3] = {-32000, 0, 0};
+  memcpy(imu.fifo[0], hit, sizeof(hit));
+  imu.fifoCount = 1;
+
+  imu.regs[LSM303D_IG_SRC1] = 0x40 | 0x02;
+  TEST_ASSERT_TRUE(collision->poll(*impacts));
+
+  JarImpactEvent event;
+  TEST_ASSERT_TRUE(reader->next(event));
+  TEST_ASSERT_UINT16_WITHIN(2, 6000, event.magnitude);
+  TEST_ASSERT_EQUAL_UINT8(128, event.direction);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_filters_gravity_out);
+  RUN_TEST(test_begin_again_applies_new_thresholds);
+  RUN_TEST(test_nothing_without_event);
+  RUN_TEST(test_click_direction_from_sign_bits);
+  RUN_TEST(test_threshold_uses_click_sign);
+  RUN_TEST(test_threshold_alone_is_unsigned);
+  RUN_TEST(test_fifo_reports_peak);
+  RUN_TEST(test_fifo_peak_beyond_16_bits);
+  return UNITY_END();
+}
@@ -0,0 +1,337 @@
+#include <unity.h>
+#include <jarFixed.h>
+#include <math.h>
+
+#ifndef ARDUINO
+#include <chrono>
+#endif
+
+// Accuracy of the fixed-point kernels against a float reference, and
+// how long each takes next to the float code it replaces. In the
+// simavr environment this runs on an AVR, so the inline multiplier
+// code is checked against the compiler's own multiply and the
+// timings are AVR ones. Kept small enough for the 2 KB of the
+// simulated ATmega328P.
+
+#define BENCH_RUNS 64
+
+static uint32_t benchMicros()
+{
+#ifdef ARDUINO
+  return micros();
+#else
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Same pseudo-random sequence on every platform.
+static uint32_t seed;
+static int16_t random16()
+{
+  seed = seed * 1103515245UL + 12345;
+  return seed >> 16;
+}
+
+static void reportError(const char *name, float worst)
+{
+  char message[64];
+  snprintf(message, sizeof(message), "%s: worst error %ld/1000 LSB", name, (long)(worst * 1000));
+  TEST_MESSAGE(message);
+}
+
+static void reportTime(const char *name, uint32_t fixedUs, uint32_t floatUs)
+{
+  char message[80];
+  snprintf(message, sizeof(message), "%s: %lu us fixed, %lu us float per %u calls",
+           name, (unsigned long)fixedUs, (unsigned long)floatUs, BENCH_RUNS);
+  TEST_MESSAGE(message);
+}
+
+void setUp() { seed = 1; }
+void tearDown() {}
+
+void test_mul16_matches_compiler_multiply()
+{
+  static const int16_t edges[] = {0, 1, -1, 2, -2, 255, 256, -256, 32767, -32767, -32768, 12345, -12345};
+  const uint8_t count = sizeof(edges) / sizeof(edges[0]);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    for (uint8_t j = 0; j < count; j++)
+    {
+      TEST_ASSERT_EQUAL_INT32((int32_t)edges[i] * edges[j], JarFixed::mul16(edges[i], edges[j]));
+    }
+  }
+  for (uint16_t i = 0; i < 2000; i++)
+  {
+    int16_t a = random16(), b = random16();
+    TEST_ASSERT_EQUAL_INT32((int32_t)a * b, JarFixed::mul16(a, b));
+  }
+}
+
+void test_products_round_and_saturate()
+{
+  float worst8 = 0, worst15 = 0;
+  for (uint16_t i = 0; i < 2000; i++)
+  {
+    int16_t a = random16(), b = random16();
+    float q8 = (float)a * b / 256;
+    float q15 = (float)a * b / 32768;
+    if (q8 >= -32768 && q8 <= 32767)
+    {
+      worst8 = max(worst8, fabsf(JarFixed::mulQ8(a, b) - q8));
+    }
+    else
+    {
+      TEST_ASSERT_EQUAL_INT16(q8 > 0 ? 32767 : -32768, JarFixed::mulQ8(a, b));
+    }
+    worst15 = max(worst15, fabsf(JarFixed::mulQ15(a, b) - q15));
+  }
+  reportError("mulQ8", worst8);
+  reportError("mulQ15", worst15);
+  TEST_ASSERT_LESS_OR_EQUAL(0.501f, worst8);
+  TEST_ASSERT_LESS_OR_EQUAL(0.501f, worst15);
+  TEST_ASSERT_EQUAL_INT16(32767, JarFixed::mulQ15(-32768, -32768));
+  TEST_ASSERT_EQUAL_INT16(-32768, JarFixed::mulQ8(32767, -32768));
+}
+
+void test_mac_saturates()
+{
+  TEST_ASSERT_EQUAL_INT32(100 + 6, JarFixed::mac(100, 2, 3));
+  TEST_ASSERT_EQUAL_INT32(100 - 6, JarFixed::msc(100, 2, 3));
+  TEST_ASSERT_EQUAL_INT32(0x7FFFFFFFL, JarFixed::mac(0x7FFFFFF0L, 32767, 32767));
+  TEST_ASSERT_EQUAL_INT32(-0x7FFFFFFFL - 1, JarFixed::mac(-0x7FFFFFF0L, 32767, -32768));
+  TEST_ASSERT_EQUAL_INT32(0x7FFFFFFFL, JarFixed::msc(0x7FFFFFF0L, 32767, -32768));
+  TEST_ASSERT_EQUAL_INT32(-0x7FFFFFFFL - 1, JarFixed::msc(-0x7FFFFFF0L, 32767, 32767));
+}
+
+// sin() scaled to Q1.15, where 1 itself is not representable.
+static float sinQ15(float turns)
+{
+  float s = sinf(turns * 2 * (float)M_PI) * 32768;
+  return s > 32767 ? 32767 : s;
+}
+
+void test_sin_cos_accuracy()
+{
+  float worst8 = 0, worst16 = 0;
+  for (uint16_t a = 0; a < 256; a++)
+  {
+    worst8 = max(worst8, fabsf(JarFixed::sin8(a) - sinQ15(a / 256.0f)));
+    worst8 = max(worst8, fabsf(JarFixed::cos8(a) - sinQ15(a / 256.0f + 0.25f)));
+  }
+  for (uint32_t a = 0; a < 65536; a += 37)
+  {
+    worst16 = max(worst16, fabsf(JarFixed::sin16(a) - sinQ15(a / 65536.0f)));
+    worst16 = max(worst16, fabsf(JarFixed::cos16(a) - sinQ15(a / 65536.0f + 0.25f)));
+  }
+  reportError("sin8/cos8", worst8);
+  reportError("sin16/cos16", worst16);
+  TEST_ASSERT_LESS_OR_EQUAL(1.0f, worst8);
+  TEST_ASSERT_LESS_OR_EQUAL(4.0f, worst16);
+}
+
+void test_atan2_accuracy()
+{
+  float worst = 0;
+  for (uint16_t i = 0; i < 3000; i++)
+  {
+    int16_t y = random16(), x = random16();
+    if (i < 8)
+    {
+      // The axes and diagonals, and the extremes.
+      static const int16_t ys[] = {0, 1, 0, -1, 32767, -32768, 5, -5};
+      static const int16_t xs[] = {1, 0, -1, 0, 32767, -32768, -5, 5};
+      y = ys[i];
+      x = xs[i];
+    }
+    float expected = atan2f(y, x) * 32768 / (float)M_PI;
+    float error = fabsf((int16_t)(JarFixed::atan2(y, x) - (uint16_t)(int32_t)lroundf(expected)));
+    worst = max(worst, error);
+  }
+  reportError("atan2 (65536 per turn)", worst);
+  TEST_ASSERT_LESS_OR_EQUAL(8.0f, worst);
+}
+
+void test_sqrt_and_norm_are_exact()
+{
+  for (uint16_t i = 0; i < 2000; i++)
+  {
+    uint32_t x = ((uint32_t)(uint16_t)random16() << 16) | (uint16_t)random16();
+    if (i < 4)
+    {
+      static const uint32_t edges[] = {0, 1, 0xFFFFFFFFUL, 0xFFFE0001UL};
+      x = edges[i];
+    }
+    uint32_t r = JarFixed::sqrt(x);
+    TEST_ASSERT_TRUE(r * r <= x);
+    TEST_ASSERT_TRUE((r + 1) * (r + 1) > x || r == 65535);
+  }
+  for (uint16_t i = 0; i < 1000; i++)
+  {
+    int16_t x = random16(), y = random16(), z = random16();
+    float n2 = sqrtf((float)x * x + (float)y * y);
+    float n3 = sqrtf((float)x * x + (float)y * y + (float)z * z);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, n2, JarFixed::norm(x, y));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, n3, JarFixed::norm(x, y, z));
+  }
+  TEST_ASSERT_EQUAL_UINT16(46340, JarFixed::norm(-32768, -32768));
+  TEST_ASSERT_EQUAL_UINT16(56755, JarFixed::norm(-32768, -32768, -32768));
+}
+
+void test_low_pass_tracks_float()
+{
+  JarLowPass filter(3);
+  float reference = 0;
+  float worst = 0;
+  for (uint16_t i = 0; i < 500; i++)
+  {
+    int16_t x = (i / 50) % 2 ? 10000 : -3000;
+    reference += (x - reference) / 8;
+    worst = max(worst, fabsf(filter.update(x) - reference));
+  }
+  reportError("low-pass", worst);
+  TEST_ASSERT_LESS_OR_EQUAL(1.0f, worst);
+}
+
+// Second-order Butterworth low-pass at a tenth of the sample rate.
+static const float fb0 = 0.0675f, fb1 = 0.1349f, fb2 = 0.0675f, fa1 = -1.1430f, fa2 = 0.4128f;
+#define Q14(x) ((int16_t)lroundf((x) * 16384))
+
+void test_biquad_tracks_float()
+{
+  JarBiquad filter(Q14(fb0), Q14(fb1), Q14(fb2), Q14(fa1), Q14(fa2));
+  float x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+  float worst = 0;
+  for (uint16_t i = 0; i < 1000; i++)
+  {
+    int16_t x = random16() / 4 + ((i / 100) % 2 ? 8000 : -8000);
+    float y = fb0 * x + fb1 * x1 + fb2 * x2 - fa1 * y1 - fa2 * y2;
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    worst = max(worst, fabsf(filter.update(x) - y));
+  }
+  reportError("biquad", worst);
+  // The reference uses the exact coefficients, not the Q2.14 ones.
+  TEST_ASSERT_LESS_OR_EQUAL(4.0f, worst);
+}
+
+void test_moving_average()
+{
+  JarMovingAverage<8> average;
+  int16_t samples[8] = {0};
+  float worst = 0;
+  for (uint16_t i = 0; i < 500; i++)
+  {
+    int16_t x = random16();
+    samples[i & 7] = x;
+    float sum = 0;
+    for (uint8_t j = 0; j < 8; j++) { sum += samples[j]; }
+    worst = max(worst, fabsf(average.update(x) - sum / 8));
+  }
+  reportError("moving average", worst);
+  TEST_ASSERT_LESS_OR_EQUAL(0.5f, worst);
+
+  // The difference of the new and the dropped sample does not fit
+  // in 16 bits.
+  average.reset(-32768);
+  for (uint8_t i = 0; i < 8; i++) { average.update(32767); }
+  TEST_ASSERT_EQUAL_INT16(32767, average.value());
+  for (uint8_t i = 0; i < 8; i++) { average.update(-32768); }
+  TEST_ASSERT_EQUAL_INT16(-32768, average.value());
+}
+
+// Keeps the benchmarked results alive.
+static volatile int32_t sink;
+static volatile float floatSink;
+
+void test_benchmark_against_float()
+{
+  static int16_t a[BENCH_RUNS], b[BENCH_RUNS];
+  static float fa[BENCH_RUNS], fb[BENCH_RUNS];
+  for (uint16_t i = 0; i < BENCH_RUNS; i++)
+  {
+    a[i] = random16();
+    b[i] = random16();
+    fa[i] = a[i] / 32768.0f;
+    fb[i] = b[i] / 32768.0f;
+  }
+
+  uint32_t start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { sink = JarFixed::mulQ15(a[i], b[i]); }
+  uint32_t fixedUs = benchMicros() - start;
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { floatSink = fa[i] * fb[i]; }
+  reportTime("mulQ15", fixedUs, benchMicros() - start);
+
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { sink = JarFixed::sin16(a[i]); }
+  fixedUs = benchMicros() - start;
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { floatSink = sinf(fa[i] * (float)M_PI); }
+  reportTime("sin16", fixedUs, benchMicros() - start);
+
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { sink = JarFixed::atan2(a[i], b[i]); }
+  fixedUs = benchMicros() - start;
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { floatSink = atan2f(fa[i], fb[i]); }
+  reportTime("atan2", fixedUs, benchMicros() - start);
+
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { sink = JarFixed::norm(a[i], b[i]); }
+  fixedUs = benchMicros() - start;
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { floatSink = sqrtf(fa[i] * fa[i] + fb[i] * fb[i]); }
+  reportTime("norm", fixedUs, benchMicros() - start);
+
+  JarBiquad filter(Q14(fb0), Q14(fb1), Q14(fb2), Q14(fa1), Q14(fa2));
+  float x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++) { sink = filter.update(a[i]); }
+  fixedUs = benchMicros() - start;
+  start = benchMicros();
+  for (uint16_t i = 0; i < BENCH_RUNS; i++)
+  {
+    float y = fb0 * fa[i] + fb1 * x1 + fb2 * x2 - fa1 * y1 - fa2 * y2;
+    x2 = x1;
+    x1 = fa[i];
+    y2 = y1;
+    y1 = y;
+    floatSink = y;
+  }
+  reportTime("biquad", fixedUs, benchMicros() - start);
+}
+
+int runUnityTests()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_mul16_matches_compiler_multiply);
+  RUN_TEST(test_products_round_and_saturate);
+  RUN_TEST(test_mac_saturates);
+  RUN_TEST(test_sin_cos_accuracy);
+  RUN_TEST(test_atan2_accuracy);
+  RUN_TEST(test_sqrt_and_norm_are_exact);
+  RUN_TEST(test_low_pass_tracks_float);
+  RUN_TEST(test_biquad_tracks_float);
+  RUN_TEST(test_moving_average);
+  RUN_TEST(test_benchmark_against_float);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+  delay(2000);
+  runUnityTests();
+}
+
+void loop() {}
+#else
+int main()
+{
+  return runUnityTests();
+}
+#endif
@@ -0,0 +1,170 @@
+#include <unity.h>
+#include <jarLineFast.h>
+
+// Sensor pins 0-2 on port 0 and the emitters on pin 11. The time
+// hook plays the sensor capacitors: while a pin is driven it reads
+// its output, and once released it reads high for as long as that
+// sensor takes to discharge. Every micros() costs 1 us.
+static const uint8_t pins[LINE_FAST_SENSORS] = {0, 1, 2};
+#define EMITTER_PIN 11
+
+struct FakeSensors
+{
+  uint16_t decay[LINE_FAST_SENSORS];
+  uint16_t noisyLow, noisyHigh;
+  bool charged;
+  uint32_t released;
+  uint16_t charges;
+};
+
+static FakeSensors sensors;
+static JarLineFast *lineFast;
+
+static void tick()
+{
+  volatile uint8_t *ddr = JarHost::ddrRegisters();
+  volatile uint8_t *pin = JarHost::pinRegisters();
+  volatile uint8_t *port = JarHost::portRegisters();
+
+  JarHost::advanceMicros(1);
+  if (ddr[0] & 0x07)
+  {
+    sensors.charged = true;
+    pin[0] = port[0];
+    return;
+  }
+  if (sensors.charged)
+  {
+    // Sensor 2 sits on the threshold and reads either side of it
+    // on alternate charges.
+    sensors.charged = false;
+    sensors.released = JarHost::clock();
+    sensors.charges++;
+    if (sensors.noisyLow)
+    {
+      sensors.decay[2] = (sensors.charges & 1) ? sensors.noisyLow : sensors.noisyHigh;
+    }
+  }
+  uint32_t elapsed = JarHost::clock() - sensors.released;
+  pin[0] = 0;
+  for (uint8_t i = 0; i < LINE_FAST_SENSORS; i++)
+  {
+    if (elapsed < sensors.decay[i]) { pin[0] |= 1 << i; }
+  }
+}
+
+static uint32_t timedRead(uint16_t values[LINE_FAST_SENSORS], bool decide, uint8_t *dark)
+{
+  uint32_t start = JarHost::clock();
+  *dark = lineFast->read(values, true, decide);
+  return JarHost::clock() - start;
+}
+
+// Calibrated from 100 to 1000 us: thresholds at 550 us, timeouts at
+// 1125 us.
+void setUp()
+{
+  static JarLineFast storage;
+  storage = JarLineFast();
+  lineFast = &storage;
+  memset(&sensors, 0, sizeof(sensors));
+  // The emitters are already on, so reads pay no settle time.
+  JarHost::ddrRegisters()[0] = JarHost::portRegisters()[0] = 0;
+  JarHost::ddrRegisters()[1] = JarHost::portRegisters()[1] = 0x08;
+  JarHost::timeHook() = tick;
+  lineFast->begin(pins, EMITTER_PIN);
+
+  static const uint16_t minimum[LINE_FAST_SENSORS] = {100, 100, 100};
+  static const uint16_t maximum[LINE_FAST_SENSORS] = {1000, 1000, 1000};
+  lineFast->setCalibration(minimum, maximum);
+  lineFast->resetStats();
+
+  sensors.decay[0] = 200;
+  sensors.decay[1] = 1800;
+  sensors.decay[2] = 900;
+}
+
+void tearDown()
+{
+  JarHost::timeHook() = 0;
+}
+
+void test_decision_stops_at_threshold()
+{
+  uint16_t values[LINE_FAST_SENSORS];
+  uint8_t dark;
+  uint32_t took = timedRead(values, true, &dark);
+
+  TEST_ASSERT_EQUAL_HEX8(0x06, dark);
+  TEST_ASSERT_UINT16_WITHIN(1, 200, values[0]);
+  TEST_ASSERT_EQUAL_UINT16(550, values[1]);
+  TEST_ASSERT_EQUAL_UINT16(550, values[2]);
+  TEST_ASSERT_LESS_THAN(600, took);
+}
+
+void test_full_read_waits_for_calibrated_timeout()
+{
+  uint16_t values[LINE_FAST_SENSORS];
+  uint8_t dark;
+  uint32_t took = timedRead(values, false, &dark);
+
+  TEST_ASSERT_EQUAL_HEX8(0x06, dark);
+  TEST_ASSERT_UINT16_WITHIN(1, 200, values[0]);
+  TEST_ASSERT_EQUAL_UINT16(1125, values[1]);
+  TEST_ASSERT_UINT16_WITHIN(1, 900, values[2]);
+  TEST_ASSERT_GREATER_OR_EQUAL(1125, took);
+  TEST_ASSERT_LESS_THAN(LINE_FAST_FULL_TIMEOUT, took);
+}
+
+void test_check_compares_with_full_read()
+{
+  uint16_t values[LINE_FAST_SENSORS];
+  uint8_t dark;
+  for (uint8_t i = 0; i < LINE_FAST_CHECK_EVERY - 1; i++)
+  {
+    lineFast->read(values, true, true);
+  }
+  TEST_ASSERT_EQUAL_UINT16(LINE_FAST_CHECK_EVERY - 1, sensors.charges);
+
+  // The full read of the check runs to the sensor that is darkest.
+  uint32_t took = timedRead(values, true, &dark);
+  TEST_ASSERT_EQUAL_UINT16(LINE_FAST_CHECK_EVERY + 1, sensors.charges);
+  TEST_ASSERT_GREATER_OR_EQUAL(550 + 1800, took);
+  TEST_ASSERT_EQUAL_UINT16(0, lineFast->mismatches());
+  TEST_ASSERT_LESS_OR_EQUAL(1, lineFast->meanError());
+}
+
+void test_check_counts_mismatches()
+{
+  // Threshold 550: the fast read sees 600 (dark) and the full read
+  // right after it 500 (light).
+  sensors.noisyLow = 500;
+  sensors.noisyHigh = 600;
+
+  uint16_t values[LINE_FAST_SENSORS];
+  uint8_t dark = 0;
+  for (uint8_t i = 0; i < LINE_FAST_CHECK_EVERY; i++)
+  {
+    dark = lineFast->read(values, true, true);
+  }
+  TEST_ASSERT_EQUAL_HEX8(0x06, dark);
+  TEST_ASSERT_EQUAL_UINT16(1, lineFast->mismatches());
+
+  // Sensor 2 was cut at 550 and the full read gave 500; the others
+  // agree to within the 1 us tick.
+  TEST_ASSERT_UINT16_WITHIN(1, 50 / 3, lineFast->meanError());
+
+  lineFast->resetStats();
+  TEST_ASSERT_EQUAL_UINT16(0, lineFast->mismatches());
+  TEST_ASSERT_EQUAL_UINT16(0, lineFast->meanError());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_decision_stops_at_threshold);
+  RUN_TEST(test_full_read_waits_for_calibrated_timeout);
+  RUN_TEST(test_check_compares_with_full_read);
+  RUN_TEST(test_check_counts_mismatches);
+  return UNITY_END();
+}
@@ -0,0 +1,97 @@
+#include <unity.h>
+#include <jarHost.h>
+#include <jarButton.h>
+#include <jarMenu.h>
+
+typedef JarButton<HostBuzzer, HostButton, HostButton, HostButton> HostButtons;
+
+// Presses the buttons in a script, one per monitor() call, so that
+// JarMenu::select() can be run to completion.
+struct ScriptedButtons
+{
+  const char *script;
+  char monitor() { return *script ? *script++ : 'B'; }
+};
+
+static uint8_t ran;
+static void runFirst() { ran = 1; }
+static void runSecond() { ran = 2; }
+static void runThird() { ran = 3; }
+
+static JarMenuItem items[] = {
+  { F("First"), runFirst },
+  { F("Second"), runSecond },
+  { F("Third"), runThird },
+};
+
+void setUp() { ran = 0; }
+void tearDown() {}
+
+void test_button_press_beeps_once()
+{
+  HostButtons buttons;
+  TEST_ASSERT_EQUAL(0, buttons.monitor());
+
+  buttons.buttonC.press();
+  TEST_ASSERT_EQUAL('C', buttons.monitor());
+  TEST_ASSERT_EQUAL_STRING(beepButtonC, buttons.buzzer.last);
+  TEST_ASSERT_TRUE(buttons.cIsPressed());
+
+  // Holding the button is not another press.
+  TEST_ASSERT_EQUAL(0, buttons.monitor());
+  TEST_ASSERT_EQUAL(1, buttons.buzzer.count);
+  buttons.buttonC.release();
+  TEST_ASSERT_FALSE(buttons.cIsPressed());
+}
+
+void test_menu_shows_first_item()
+{
+  HostLcd lcd;
+  ScriptedButtons buttons = { "" };
+  JarMenu<HostLcd, ScriptedButtons> menu(items, 3, lcd, buttons);
+  menu.select();
+  TEST_ASSERT_EQUAL(1, ran);
+  TEST_ASSERT_EQUAL_STRING("First   ", lcd.line(0));
+}
+
+void test_menu_scrolls_and_wraps()
+{
+  HostLcd lcd;
+  ScriptedButtons buttons = { "CC" };
+  JarMenu<HostLcd, ScriptedButtons> menu(items, 3, lcd, buttons);
+  menu.select();
+  TEST_ASSERT_EQUAL(3, ran);
+
+  // C past the last item wraps to the first, A before the first
+  // wraps to the last. The menu remembers where it was.
+  buttons.script = "C";
+  menu.select();
+  TEST_ASSERT_EQUAL(1, ran);
+  buttons.script = "A";
+  menu.select();
+  TEST_ASSERT_EQUAL(3, ran);
+  TEST_ASSERT_EQUAL_STRING("Third   ", lcd.line(0));
+}
+
+void test_menu_with_real_buttons()
+{
+  HostLcd lcd;
+  HostButtons buttons;
+  JarMenu<HostLcd, HostButtons> menu(items, 3, lcd, buttons);
+
+  // A queued press of B selects the item on screen.
+  buttons.buttonB.press();
+  menu.select();
+  TEST_ASSERT_EQUAL(1, ran);
+  TEST_ASSERT_EQUAL_STRING(beepButtonB, buttons.buzzer.last);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_button_press_beeps_once);
+  RUN_TEST(test_menu_shows_first_item);
+  RUN_TEST(test_menu_scrolls_and_wraps);
+  RUN_TEST(test_menu_with_real_buttons);
+  return UNITY_END();
+}
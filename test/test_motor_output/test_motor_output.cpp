@@ -0,0 +1,92 @@
+#include <unity.h>
+#include <jarMotorOutput.h>
+
+struct FakeMotors
+{
+  int16_t left, right;
+  uint8_t calls;
+
+  void setSpeeds(int16_t l, int16_t r)
+  {
+    left = l;
+    right = r;
+    calls++;
+  }
+};
+
+static FakeMotors motors;
+static JarMotorOutput<FakeMotors> *output;
+
+// 1.5 A through 1 ohm allows 1500 mV beyond the back EMF, which is
+// 1 mV per count per second.
+void setUp()
+{
+  static JarMotorOutput<FakeMotors> storage(motors);
+  output = &storage;
+  memset(&motors, 0, sizeof(motors));
+  output->resume();
+  output->setLimits(5000, 1500, 1000, 1000);
+  output->setBattery(5000);
+  output->setSpeeds(0, 0);
+}
+
+void tearDown() {}
+
+void test_zero_effort_is_off_at_any_speed()
+{
+  TEST_ASSERT_EQUAL_INT16(0, output->toPwm(0, 2000));
+  TEST_ASSERT_EQUAL_INT16(0, output->toPwm(0, -2000));
+  output->setSpeeds(3000, -3000);
+  output->setEfforts(0, 0);
+  TEST_ASSERT_EQUAL_INT16(0, motors.left);
+  TEST_ASSERT_EQUAL_INT16(0, motors.right);
+}
+
+void test_stall_current_limited()
+{
+  // 1500 mV of the 5000 mV battery.
+  TEST_ASSERT_EQUAL_INT16(120, output->toPwm(400, 0));
+  TEST_ASSERT_EQUAL_INT16(-120, output->toPwm(-400, 0));
+  TEST_ASSERT_EQUAL_INT16(50, output->toPwm(50, 0));
+}
+
+void test_reversal_limited_around_back_emf()
+{
+  // Running forward at 2000 mV of back EMF, full reverse may only
+  // pull the wheel voltage down to 500 mV.
+  TEST_ASSERT_EQUAL_INT16(40, output->toPwm(-400, 2000));
+  TEST_ASSERT_EQUAL_INT16(280, output->toPwm(400, 2000));
+}
+
+void test_scaled_for_battery()
+{
+  output->setBattery(4000);
+  TEST_ASSERT_EQUAL_INT16(250, output->toPwm(200, 2000));
+  output->setBattery(2000);
+  TEST_ASSERT_EQUAL_INT16(MOTOR_OUTPUT_MAX, output->toPwm(400, 3000));
+}
+
+void test_stop_ignores_commands_until_resume()
+{
+  output->setEfforts(100, 100);
+  TEST_ASSERT_EQUAL_INT16(100, motors.left);
+  output->stop();
+  TEST_ASSERT_EQUAL_INT16(0, motors.left);
+  output->setEfforts(100, 100);
+  TEST_ASSERT_EQUAL_INT16(0, motors.left);
+  output->resume();
+  output->setEfforts(100, -100);
+  TEST_ASSERT_EQUAL_INT16(100, motors.left);
+  TEST_ASSERT_EQUAL_INT16(-100, motors.right);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_zero_effort_is_off_at_any_speed);
+  RUN_TEST(test_stall_current_limited);
+  RUN_TEST(test_reversal_limited_around_back_emf);
+  RUN_TEST(test_scaled_for_battery);
+  RUN_TEST(test_stop_ignores_commands_until_resume);
+  return UNITY_END();
+}
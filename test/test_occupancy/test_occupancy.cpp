@@ -0,0 +1,220 @@
+#include <unity.h>
+#include <jarOccupancy.h>
+
+#ifndef ARDUINO
+#include <chrono>
+#endif
+
+// One proximity update, a nearest() query and the share of a decay
+// must fit in a tenth of the 20 ms proximity period of the firmware.
+#define UPDATE_BUDGET_US 2000
+#define BENCH_RUNS 50
+
+// Microseconds of real time: the AVR timer when this runs on the
+// target or in simavr, the host clock in the native build.
+static uint32_t benchMicros()
+{
+#ifdef ARDUINO
+  return micros();
+#else
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static JarOccupancy grid;
+static const uint8_t center = OCC_GRID_SIZE / 2;
+
+static JarPose poseAt(int16_t xMm, int16_t yMm, uint16_t heading)
+{
+  JarPose pose;
+  pose.x = (int32_t)xMm * 256;
+  pose.y = (int32_t)yMm * 256;
+  pose.heading = heading;
+  return pose;
+}
+
+static uint16_t ahead(const JarPose &pose)
+{
+  return grid.nearest(pose, 0, OCC_PROX_RANGE_MM);
+}
+
+void setUp() { grid.clear(); }
+void tearDown() {}
+
+// Every count that reports an obstacle must leave one in the grid
+// ahead, the closest reading (6) included, and closer readings must
+// not report it farther away.
+void test_front_hits_are_found()
+{
+  JarPose pose = poseAt(25, 25, 0);
+  uint16_t last = 0xFFFF;
+  for (uint8_t count = 1; count <= 6; count++)
+  {
+    uint8_t counts[6] = {0, 0, count, count, 0, 0};
+    grid.clear();
+    grid.updateProx(pose, counts);
+    uint16_t distance = ahead(pose);
+    TEST_ASSERT_NOT_EQUAL(0xFFFF, distance);
+    TEST_ASSERT_GREATER_THAN(0, distance);
+    TEST_ASSERT_LESS_OR_EQUAL(last, distance);
+    last = distance;
+  }
+  TEST_ASSERT_LESS_OR_EQUAL(2 * OCC_CELL_MM, last);
+}
+
+// A hit on one front channel survives a free ray on the other.
+void test_one_sided_hit_is_kept()
+{
+  JarPose pose = poseAt(25, 25, 0);
+  uint8_t counts[6] = {0, 0, 6, 0, 0, 0};
+  grid.updateProx(pose, counts);
+  TEST_ASSERT_NOT_EQUAL(0xFFFF, ahead(pose));
+}
+
+// Free rays from any channel leave the robot's own cell alone.
+void test_free_rays_keep_own_cell()
+{
+  // Mark the robot's cell with a close hit from one cell further back.
+  uint8_t hit[6] = {0, 0, 6, 6, 0, 0};
+  grid.updateProx(poseAt(-25, 25, 0), hit);
+  uint8_t before = grid.get(center, center);
+  TEST_ASSERT_GREATER_OR_EQUAL(OCC_HIT_LEVEL, before);
+
+  uint8_t none[6] = {0, 0, 0, 0, 0, 0};
+  grid.updateProx(poseAt(25, 25, 0), none);
+  TEST_ASSERT_EQUAL(before, grid.get(center, center));
+}
+
+void test_free_rays_clear_cells()
+{
+  JarPose pose = poseAt(25, 25, 0);
+  uint8_t hit[6] = {0, 0, 2, 2, 0, 0};
+  uint8_t none[6] = {0, 0, 0, 0, 0, 0};
+  grid.updateProx(pose, hit);
+  TEST_ASSERT_NOT_EQUAL(0xFFFF, ahead(pose));
+  grid.updateProx(pose, none);
+  grid.updateProx(pose, none);
+  TEST_ASSERT_EQUAL(0xFFFF, ahead(pose));
+}
+
+void test_decay_lowers_every_cell_by_one()
+{
+  JarPose pose = poseAt(25, 25, 0);
+  uint8_t hit[6] = {6, 6, 6, 6, 6, 6};
+  grid.updateProx(pose, hit);
+  grid.updateProx(pose, hit);
+
+  uint8_t before[OCC_GRID_SIZE][OCC_GRID_SIZE];
+  uint16_t occupied = 0;
+  for (uint8_t y = 0; y < OCC_GRID_SIZE; y++)
+  {
+    for (uint8_t x = 0; x < OCC_GRID_SIZE; x++)
+    {
+      before[y][x] = grid.get(x, y);
+      occupied += before[y][x] != 0;
+    }
+  }
+  TEST_ASSERT_GREATER_THAN(0, occupied);
+
+  for (uint8_t step = 1; step <= OCC_CELL_MAX; step++)
+  {
+    grid.decay();
+    for (uint8_t y = 0; y < OCC_GRID_SIZE; y++)
+    {
+      for (uint8_t x = 0; x < OCC_GRID_SIZE; x++)
+      {
+        uint8_t expected = before[y][x] > step ? before[y][x] - step : 0;
+        TEST_ASSERT_EQUAL(expected, grid.get(x, y));
+      }
+    }
+  }
+}
+
+void test_odometry_straight_and_turn()
+{
+  JarOdometry odometry;
+  for (uint8_t i = 0; i < 100; i++)
+  {
+    odometry.update(10, 10);
+  }
+  // 1000 counts at 34/256 mm per count.
+  TEST_ASSERT_INT_WITHIN(2, 133, odometry.pose().x >> 8);
+  TEST_ASSERT_INT_WITHIN(1, 0, odometry.pose().y >> 8);
+  TEST_ASSERT_EQUAL(0, odometry.pose().heading);
+
+  // A quarter turn in place is 65536 / 4 / (3669 / 256) counts of
+  // difference between the wheels.
+  odometry.reset();
+  for (uint8_t i = 0; i < 100; i++)
+  {
+    odometry.update(-572 / 100, 572 / 100);
+  }
+  odometry.update(-(572 % 100), 572 % 100);
+  TEST_ASSERT_INT_WITHIN(200, 16384, odometry.pose().heading);
+}
+
+// Worst case for the ray updates: nothing in range, so all six rays
+// run the full 300 mm, at a heading that makes them diagonal.
+void test_update_fits_budget()
+{
+  uint8_t counts[6] = {0, 0, 0, 0, 0, 0};
+  JarPose pose = poseAt(10, 40, 0x2000);
+
+  uint32_t start = benchMicros();
+  for (uint8_t i = 0; i < BENCH_RUNS; i++)
+  {
+    grid.updateProx(pose, counts);
+  }
+  uint32_t update = (benchMicros() - start) / BENCH_RUNS;
+
+  start = benchMicros();
+  for (uint8_t i = 0; i < BENCH_RUNS; i++)
+  {
+    grid.nearest(pose, 0, OCC_PROX_RANGE_MM);
+  }
+  uint32_t nearest = (benchMicros() - start) / BENCH_RUNS;
+
+  start = benchMicros();
+  for (uint8_t i = 0; i < BENCH_RUNS; i++)
+  {
+    grid.decay();
+  }
+  uint32_t decay = (benchMicros() - start) / BENCH_RUNS;
+
+  char message[64];
+  snprintf(message, sizeof(message), "updateProx %lu us, nearest %lu us, decay %lu us",
+           (unsigned long)update, (unsigned long)nearest, (unsigned long)decay);
+  TEST_MESSAGE(message);
+
+  // Decay runs once a second, so only its share of a tick counts.
+  TEST_ASSERT_LESS_OR_EQUAL(UPDATE_BUDGET_US, update + nearest + decay / 50);
+}
+
+int runUnityTests()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_front_hits_are_found);
+  RUN_TEST(test_one_sided_hit_is_kept);
+  RUN_TEST(test_free_rays_keep_own_cell);
+  RUN_TEST(test_free_rays_clear_cells);
+  RUN_TEST(test_decay_lowers_every_cell_by_one);
+  RUN_TEST(test_odometry_straight_and_turn);
+  RUN_TEST(test_update_fits_budget);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+  delay(2000);
+  runUnityTests();
+}
+
+void loop() {}
+#else
+int main()
+{
+  return runUnityTests();
+}
+#endif
@@ -0,0 +1,140 @@
+#include <unity.h>
+#include <jarHost.h>
+#include <jarParams.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+static JarParams params;
+
+// A blank EEPROM reads as all ones.
+void setUp()
+{
+  memset(JarHost::eeprom(), 0xFF, E2END + 1);
+  params.setDefaults();
+}
+
+void tearDown() {}
+
+static void expectDefaults(const JarParams &p)
+{
+  for (uint8_t i = 0; i < PARAM_COUNT; i++)
+  {
+    JarParamInfo info;
+    JarParams::info((JarParamId)i, &info);
+    TEST_ASSERT_EQUAL_INT16(info.def, p.get((JarParamId)i));
+  }
+}
+
+void test_blank_eeprom_gives_defaults()
+{
+  params.set(PARAM_MOTOR_KP, 1000);
+  TEST_ASSERT_FALSE(params.load());
+  expectDefaults(params);
+}
+
+void test_saved_image_loads_back()
+{
+  params.set(PARAM_MOTOR_KP, 1000);
+  params.set(PARAM_GYRO_BIAS_Z, -17);
+  params.set(PARAM_CALIBRATED, 1);
+  params.save();
+
+  JarParams loaded;
+  TEST_ASSERT_TRUE(loaded.load());
+  for (uint8_t i = 0; i < PARAM_COUNT; i++)
+  {
+    TEST_ASSERT_EQUAL_INT16(params.get((JarParamId)i), loaded.get((JarParamId)i));
+  }
+  TEST_ASSERT_EQUAL_INT16(-17, loaded.get<PARAM_GYRO_BIAS_Z>());
+}
+
+void test_corrupt_image_gives_defaults()
+{
+  params.set(PARAM_MOTOR_KP, 1000);
+  params.save();
+  JarHost::eeprom()[PARAMS_EEPROM_ADDRESS + offsetof(JarParamImage, values) + 1] ^= 0x04;
+
+  JarParams loaded;
+  loaded.set(PARAM_MOTOR_KP, 2000);
+  TEST_ASSERT_FALSE(loaded.load());
+  expectDefaults(loaded);
+}
+
+// An image from another firmware version, or with another number of
+// parameters, is ignored even though its CRC matches.
+void test_other_layout_gives_defaults()
+{
+  params.set(PARAM_MOTOR_KP, 1000);
+  params.save();
+
+  JarParamImage image;
+  eeprom_read_block(&image, (const void *)PARAMS_EEPROM_ADDRESS, sizeof(image));
+  image.version = PARAMS_VERSION - 1;
+  image.crc = 0;
+  const uint8_t *bytes = (const uint8_t *)&image;
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < offsetof(JarParamImage, crc); i++) { crc = _crc16_update(crc, bytes[i]); }
+  image.crc = crc;
+  eeprom_update_block(&image, (void *)PARAMS_EEPROM_ADDRESS, sizeof(image));
+
+  JarParams loaded;
+  TEST_ASSERT_FALSE(loaded.load());
+  expectDefaults(loaded);
+
+  params.save();
+  JarHost::eeprom()[PARAMS_EEPROM_ADDRESS + offsetof(JarParamImage, count)] = PARAM_COUNT - 1;
+  TEST_ASSERT_FALSE(loaded.load());
+}
+
+void test_set_clamps_beyond_int16()
+{
+  params.set(PARAM_MOTOR_KP, 40000);
+  TEST_ASSERT_EQUAL_INT16(32767, params.get<PARAM_MOTOR_KP>());
+  params.set(PARAM_MOTOR_KP, -40000);
+  TEST_ASSERT_EQUAL_INT16(0, params.get<PARAM_MOTOR_KP>());
+
+  // 70000 is 4464 once truncated to 16 bits.
+  params.set(PARAM_GYRO_THRESHOLD, 70000);
+  TEST_ASSERT_EQUAL_INT16(32000, params.get<PARAM_GYRO_THRESHOLD>());
+  params.set(PARAM_GYRO_BIAS_Z, -5000);
+  TEST_ASSERT_EQUAL_INT16(-2000, params.get<PARAM_GYRO_BIAS_Z>());
+}
+
+void test_step_stays_at_limits()
+{
+  params.set(PARAM_MOTOR_KP, 32767);
+  params.step(PARAM_MOTOR_KP, 1);
+  TEST_ASSERT_EQUAL_INT16(32767, params.get<PARAM_MOTOR_KP>());
+  params.step(PARAM_MOTOR_KP, -1);
+  TEST_ASSERT_EQUAL_INT16(32767 - 16, params.get<PARAM_MOTOR_KP>());
+
+  params.set(PARAM_MOTOR_KP, 5);
+  params.step(PARAM_MOTOR_KP, -1);
+  TEST_ASSERT_EQUAL_INT16(0, params.get<PARAM_MOTOR_KP>());
+
+  params.set(PARAM_GYRO_BIAS_Z, -2000);
+  params.step(PARAM_GYRO_BIAS_Z, -1);
+  TEST_ASSERT_EQUAL_INT16(-2000, params.get<PARAM_GYRO_BIAS_Z>());
+}
+
+void test_serial_set_clamps()
+{
+  static HostStream serial;
+  serial.in = "set MotorKp 40000\nget motorkp\n";
+  params.poll(serial);
+  serial.out[serial.outLength] = 0;
+  TEST_ASSERT_EQUAL_STRING("MotorKp=32767\r\nMotorKp=32767\r\n", (const char *)serial.out);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_blank_eeprom_gives_defaults);
+  RUN_TEST(test_saved_image_loads_back);
+  RUN_TEST(test_corrupt_image_gives_defaults);
+  RUN_TEST(test_other_layout_gives_defaults);
+  RUN_TEST(test_set_clamps_beyond_int16);
+  RUN_TEST(test_step_stays_at_limits);
+  RUN_TEST(test_serial_set_clamps);
+  return UNITY_END();
+}
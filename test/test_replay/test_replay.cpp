@@ -0,0 +1,639 @@
+#include <unity.h>
+#include <jarHost.h>
+#include <jarReplay.h>
+#include <jarButton.h>
+#include <jarDemos.h>
+#include <jarMenu.h>
+#include <jarMotorOutput.h>
+#include <jarOccupancy.h>
+#include <jarProxMapper.h>
+#include <jarTrace.h>
+#include <chrono>
+#include <new>
+
+// Records simulated runs of the firmware into a trace, then replays
+// the trace through the same firmware code under the simulated clock
+// and checks that it behaves exactly as it did live: the menu and map
+// loop of proxMapDemo, and the views and motor panel behind the line,
+// proximity, inertial and motor demos.
+//
+// JAR_TRACE=<file> replays a trace captured on the robot (the bytes
+// streamed by the Record demo) through the same code instead.
+
+typedef JarButton<HostBuzzer, HostButton, HostButton, HostButton> HostButtons;
+
+static JarBus bus;
+static JarTrace trace;
+static JarOdometry odometry;
+static JarOccupancy grid;
+static JarProxMapper mapper(odometry, grid);
+
+// What the firmware did after each proximity update.
+struct Output
+{
+  int32_t x;
+  int32_t y;
+  uint16_t heading;
+  uint16_t ahead;
+  bool aHeld;
+};
+
+#define MAX_OUTPUTS 1024
+
+struct Run
+{
+  Output outputs[MAX_OUTPUTS];
+  uint16_t count;
+  bool mapped;
+};
+
+// The firmware under test: a menu with an idle item and the map loop
+// of proxMapDemo, which also watches button A being held. It runs on
+// the live robot and on the replay alike.
+template <class Buttons>
+struct Firmware
+{
+  static Buttons *buttons;
+  static Run *run;
+
+  static void idle()
+  {
+    while (buttons->monitor() != 'B') {}
+  }
+
+  static void map()
+  {
+    run->mapped = true;
+    mapper.begin(bus, millis());
+    while (buttons->monitor() != 'B')
+    {
+      bool aHeld = buttons->aIsPressed();
+      if (mapper.update(bus, millis()) && run->count < MAX_OUTPUTS)
+      {
+        Output &out = run->outputs[run->count++];
+        out.x = odometry.pose().x;
+        out.y = odometry.pose().y;
+        out.heading = odometry.pose().heading;
+        out.ahead = mapper.ahead();
+        out.aHeld = aHeld;
+      }
+    }
+  }
+
+  static void start(Buttons &b, Run &r)
+  {
+    static JarMenuItem items[] = {
+      { F("Idle"), idle },
+      { F("Map"), map },
+    };
+    HostLcd lcd;
+    buttons = &b;
+    run = &r;
+    r.count = 0;
+    r.mapped = false;
+    JarMenu<HostLcd, Buttons> menu(items, 2, lcd, b);
+    menu.select();
+  }
+};
+
+template <class Buttons> Buttons *Firmware<Buttons>::buttons;
+template <class Buttons> Run *Firmware<Buttons>::run;
+
+// Button changes of the simulated run: select Map, hold A for a
+// while, leave with B.
+struct ButtonEvent
+{
+  uint16_t time;
+  char button;
+  bool down;
+};
+
+static const ButtonEvent script[] = {
+  { 100, 'C', true }, { 150, 'C', false },
+  { 300, 'B', true }, { 350, 'B', false },
+  { 2000, 'A', true }, { 2600, 'A', false },
+  { 6300, 'B', true }, { 6350, 'B', false },
+};
+
+// Runs the demo loops of main.cpp one after the other, each until B
+// is pressed, and logs every LCD frame and motor command they give.
+struct Frame
+{
+  char lcd[2][9];
+  int16_t left;
+  int16_t right;
+};
+
+#define MAX_FRAMES 4096
+
+struct Tour
+{
+  Frame frames[MAX_FRAMES];
+  uint16_t count;
+
+  // Keeps a frame when something changed.
+  void add(const HostLcd &lcd, const HostMotors &motors)
+  {
+    Frame frame;
+    memcpy(frame.lcd[0], lcd.line(0), 9);
+    memcpy(frame.lcd[1], lcd.line(1), 9);
+    frame.left = motors.left;
+    frame.right = motors.right;
+    if (count > 0 && !memcmp(&frames[count - 1], &frame, sizeof(frame))) { return; }
+    if (count < MAX_FRAMES) { frames[count++] = frame; }
+  }
+};
+
+// Parameters as the robot has them by default.
+#define TOUR_MOTOR_PERIOD_MS 50
+#define TOUR_COUNTS_PER_REV 900
+
+template <class Buttons>
+static void runTour(Buttons &buttons, HostMotors &motors, Tour &tour)
+{
+  HostLcd lcd;
+  JarMotorOutput<HostMotors> output(motors);
+  tour.count = 0;
+
+  JarLineView<HostLcd> lineView(lcd);
+  while (buttons.monitor() != 'B')
+  {
+    lineView.step(bus);
+    tour.add(lcd, motors);
+  }
+
+  JarProxView<HostLcd> proxView(lcd);
+  while (buttons.monitor() != 'B')
+  {
+    proxView.step(bus);
+    tour.add(lcd, motors);
+  }
+
+  JarInertialView<HostLcd> inertialView(lcd);
+  while (buttons.monitor() != 'B')
+  {
+    inertialView.step(bus, 0, 2000, 100);
+    tour.add(lcd, motors);
+  }
+
+  lcd.clear();
+  JarMotorPanel<HostLcd, Buttons, JarMotorOutput<HostMotors> > panel(lcd, buttons, output, true);
+  panel.begin(bus, millis());
+  while (buttons.monitor() != 'B')
+  {
+    panel.step(bus, millis(), TOUR_MOTOR_PERIOD_MS, TOUR_COUNTS_PER_REV);
+    tour.add(lcd, motors);
+  }
+  output.setEfforts(0, 0);
+  tour.add(lcd, motors);
+}
+
+// Leaves the line, proximity and inertial views with B, holds A in
+// the motor panel to run the left motor, taps C to turn the right
+// wheel once, and leaves with B.
+static const ButtonEvent tourScript[] = {
+  { 800, 'B', true }, { 850, 'B', false },
+  { 1200, 'B', true }, { 1250, 'B', false },
+  { 2500, 'B', true }, { 2550, 'B', false },
+  { 3000, 'A', true }, { 4000, 'A', false },
+  { 4500, 'C', true }, { 4580, 'C', false },
+  { 7500, 'B', true }, { 7550, 'B', false },
+};
+
+// Where the robot starts driving, at 100 mm/s, towards a wall 450 mm
+// ahead. It stops 60 mm short of it.
+#define DRIVE_START_MS 400
+#define WALL_MM 450
+#define STOP_MM 390
+
+// The robot on the floor: each monitor() call is one millisecond, in
+// which the buttons change as scripted and the sensors are published
+// and recorded on the periods of acquireSensors(). Without motors it
+// drives towards the wall; with them its wheels turn at a hundredth
+// of a count per ms per unit of PWM.
+class SimRobot
+{
+public:
+  SimRobot(const ButtonEvent *script, uint8_t length, HostMotors *motors = 0)
+    : traced(hardware, trace), script(script), length(length), step(0), motors(motors)
+  {
+    memset(&encoders, 0, sizeof(encoders));
+    wheels[0] = wheels[1] = 0;
+  }
+
+  char monitor()
+  {
+    tick();
+    return traced.monitor();
+  }
+
+  bool aIsPressed() { return traced.aIsPressed(); }
+  bool bIsPressed() { return traced.bIsPressed(); }
+  bool cIsPressed() { return traced.cIsPressed(); }
+
+private:
+  HostButton &button(char name)
+  {
+    return name == 'A' ? hardware.buttonA : (name == 'B' ? hardware.buttonB : hardware.buttonC);
+  }
+
+  void tick()
+  {
+    JarHost::advanceMillis(1);
+    uint16_t now = millis();
+
+    while (step < length && script[step].time <= now)
+    {
+      if (script[step].down) { button(script[step].button).press(); }
+      else { button(script[step].button).release(); }
+      step++;
+    }
+
+    int32_t travelled = 0;
+    if (motors)
+    {
+      // Published on the trace's encoder period, so every sample the
+      // loops see is in the trace.
+      wheels[0] += motors->left;
+      wheels[1] += motors->right;
+      if (now % TRACE_ENCODER_PERIOD_MS == 1)
+      {
+        encoders.time = now;
+        encoders.left = wheels[0] / 100;
+        encoders.right = wheels[1] / 100;
+        bus.encoders.publish(encoders);
+        trace.recordEncoders(encoders);
+      }
+    }
+    else
+    {
+      if (now > DRIVE_START_MS)
+      {
+        travelled = min((int32_t)(now - DRIVE_START_MS) / 10, (int32_t)STOP_MM);
+      }
+      encoders.time = now;
+      encoders.left = encoders.right = travelled * 256 / ODO_MM_PER_COUNT_Q8;
+      bus.encoders.publish(encoders);
+      trace.recordEncoders(encoders);
+    }
+
+    if (now % 10 == 1)
+    {
+      // The line drifts under the sensors, with the emitters
+      // switched off now and then.
+      JarLineSample line = { now, { 100, 1500, 100 }, (now / 300) % 4 != 0 };
+      line.values[now / 100 % 3] = now % 2000;
+      bus.line.publish(line);
+      trace.recordLine(line);
+
+      // Turning one way and then the other, and tipped over for a
+      // while.
+      JarImuSample imu = { now, { 0, 0, 8000 }, { 0, 0, 0 } };
+      imu.gyro[2] = (now / 400) % 2 ? 3000 : -3000;
+      if ((now / 700) % 3 == 2) { imu.accel[0] = -9000; }
+      bus.imu.publish(imu);
+      trace.recordImu(imu);
+    }
+
+    if (now % 20 == 0)
+    {
+      JarProxSample prox = { now, { 0, 0, 0, 0, 0, 0 } };
+      uint16_t distance = WALL_MM - travelled;
+      if (distance < OCC_PROX_RANGE_MM)
+      {
+        prox.counts[2] = prox.counts[3] = min((OCC_PROX_RANGE_MM - distance) / 43 + 1, 6);
+      }
+      bus.prox.publish(prox);
+      trace.recordProx(prox);
+    }
+
+    if (now % 100 == 0)
+    {
+      JarBatterySample battery = { now, (uint16_t)(5000 - now / 100) };
+      bus.battery.publish(battery);
+      trace.recordBattery(battery);
+    }
+  }
+
+  HostButtons hardware;
+  JarTracedButtons<HostButtons> traced;
+  const ButtonEvent *script;
+  uint8_t length;
+  uint8_t step;
+  HostMotors *motors;
+  int32_t wheels[2];
+  JarEncoderSample encoders;
+};
+
+static HostStream serial;
+static Run live, replayed;
+
+static void resetBus()
+{
+  new (&bus) JarBus();
+}
+
+static uint32_t wallMicros()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void recordLiveRun()
+{
+  resetBus();
+  serial.outLength = 0;
+  JarHost::clock() = 0;
+  SimRobot robot(script, sizeof(script) / sizeof(script[0]));
+  trace.startSerial(serial);
+  Firmware<SimRobot>::start(robot, live);
+  trace.stop();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_replay_matches_live_run()
+{
+  recordLiveRun();
+  TEST_ASSERT_TRUE(live.mapped);
+  TEST_ASSERT_GREATER_THAN(100, live.count);
+
+  resetBus();
+  JarHost::clock() = 12345678;
+  JarReplay replay(serial.out, serial.outLength, bus);
+  TEST_ASSERT_TRUE(replay.valid());
+
+  uint32_t start = wallMicros();
+  Firmware<JarReplay>::start(replay, replayed);
+  uint32_t wall = wallMicros() - start + 1;
+  uint32_t simulated = JarHost::clock() - 12345678;
+
+  char message[96];
+  snprintf(message, sizeof(message), "%u bytes, %u records, %lu ms simulated in %lu us",
+           (unsigned)serial.outLength, (unsigned)replay.records,
+           (unsigned long)(simulated / 1000), (unsigned long)wall);
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_TRUE(replayed.mapped);
+  TEST_ASSERT_EQUAL(live.count, replayed.count);
+  for (uint16_t i = 0; i < live.count; i++)
+  {
+    TEST_ASSERT_EQUAL_INT32(live.outputs[i].x, replayed.outputs[i].x);
+    TEST_ASSERT_EQUAL_INT32(live.outputs[i].y, replayed.outputs[i].y);
+    TEST_ASSERT_EQUAL_UINT16(live.outputs[i].heading, replayed.outputs[i].heading);
+    TEST_ASSERT_EQUAL_UINT16(live.outputs[i].ahead, replayed.outputs[i].ahead);
+    TEST_ASSERT_EQUAL(live.outputs[i].aHeld, replayed.outputs[i].aHeld);
+  }
+  TEST_ASSERT_GREATER_THAN(100 * wall, simulated);
+}
+
+// Regression figures of the simulated run itself.
+void test_live_run_sees_the_wall()
+{
+  recordLiveRun();
+  const Output &last = live.outputs[live.count - 1];
+  TEST_ASSERT_INT_WITHIN(3, STOP_MM, last.x >> 8);
+  TEST_ASSERT_NOT_EQUAL(0xFFFF, last.ahead);
+  TEST_ASSERT_INT_WITHIN(OCC_CELL_MM * 2, WALL_MM - STOP_MM, last.ahead);
+
+  uint16_t held = 0;
+  for (uint16_t i = 0; i < live.count; i++) { held += live.outputs[i].aHeld; }
+  TEST_ASSERT_INT_WITHIN(2, 600 / 20, held);
+}
+
+static HostMotors liveMotors, replayedMotors;
+static Tour liveTour, replayedTour;
+
+static void recordLiveTour()
+{
+  resetBus();
+  serial.outLength = 0;
+  JarHost::clock() = 0;
+  liveMotors = HostMotors();
+  SimRobot robot(tourScript, sizeof(tourScript) / sizeof(tourScript[0]), &liveMotors);
+  trace.startSerial(serial);
+  runTour(robot, liveMotors, liveTour);
+  trace.stop();
+}
+
+void test_replay_matches_live_demos()
+{
+  recordLiveTour();
+  TEST_ASSERT_LESS_THAN(sizeof(serial.out), serial.outLength);
+
+  resetBus();
+  JarHost::clock() = 987654321;
+  replayedMotors = HostMotors();
+  JarReplay replay(serial.out, serial.outLength, bus);
+  TEST_ASSERT_TRUE(replay.valid());
+  runTour(replay, replayedMotors, replayedTour);
+
+  TEST_ASSERT_EQUAL(liveTour.count, replayedTour.count);
+  for (uint16_t i = 0; i < liveTour.count; i++)
+  {
+    const Frame &live = liveTour.frames[i];
+    const Frame &replayed = replayedTour.frames[i];
+    TEST_ASSERT_EQUAL_STRING(live.lcd[0], replayed.lcd[0]);
+    TEST_ASSERT_EQUAL_STRING(live.lcd[1], replayed.lcd[1]);
+    TEST_ASSERT_EQUAL_INT16(live.left, replayed.left);
+    TEST_ASSERT_EQUAL_INT16(live.right, replayed.right);
+  }
+}
+
+// What the views and the panel showed in the simulated run.
+void test_live_demos_react()
+{
+  recordLiveTour();
+  TEST_ASSERT_LESS_THAN(MAX_FRAMES, liveTour.count);
+
+  bool emittersOff = false, turning = false, tipped = false, revolved = false;
+  int16_t fastest = 0;
+  bool rightTurned = false;
+  for (uint16_t i = 0; i < liveTour.count; i++)
+  {
+    const Frame &frame = liveTour.frames[i];
+    emittersOff |= frame.lcd[1][7] == '\xa5';
+    turning |= !memcmp(frame.lcd[0] + 6, "-Z", 2);
+    tipped |= !memcmp(frame.lcd[1] + 6, "-X", 2);
+    fastest = max(fastest, frame.left);
+    rightTurned |= frame.right == 50;
+    revolved |= frame.right == 50 && atoi(frame.lcd[0] + 5) >= TOUR_COUNTS_PER_REV - 1;
+  }
+  TEST_ASSERT_TRUE(emittersOff);
+  TEST_ASSERT_TRUE(turning);
+  TEST_ASSERT_TRUE(tipped);
+  TEST_ASSERT_GREATER_OR_EQUAL(200, fastest);
+  TEST_ASSERT_TRUE(rightTurned);
+  TEST_ASSERT_TRUE(revolved);
+
+  // Stopped after the wheel went round once, and at the end.
+  const Frame &last = liveTour.frames[liveTour.count - 1];
+  TEST_ASSERT_EQUAL_INT16(0, last.left);
+  TEST_ASSERT_EQUAL_INT16(0, last.right);
+}
+
+// Encoder totals are only recorded when they changed, at most every
+// TRACE_ENCODER_PERIOD_MS, even though they are published every pass.
+void test_encoder_records_are_rate_limited()
+{
+  recordLiveRun();
+  JarTraceReader reader(serial.out, serial.outLength);
+  JarTraceRecord record;
+  uint16_t count = 0, lastTime = 0;
+  bool first = true;
+  while (reader.next(record))
+  {
+    if (record.type != TRACE_ENCODERS) { continue; }
+    if (!first) { TEST_ASSERT_GREATER_OR_EQUAL(TRACE_ENCODER_PERIOD_MS, (uint16_t)(record.time - lastTime)); }
+    first = false;
+    lastTime = record.time;
+    count++;
+  }
+  // Moving for 3.9 s, standing still otherwise.
+  TEST_ASSERT_INT_WITHIN(5, 3900 / TRACE_ENCODER_PERIOD_MS, count);
+}
+
+void test_held_buttons_recorded_on_change()
+{
+  HostButtons hardware;
+  JarTracedButtons<HostButtons> traced(hardware, trace);
+  serial.outLength = 0;
+  JarHost::clock() = 0;
+  trace.startSerial(serial);
+  for (uint8_t i = 0; i < 10; i++)
+  {
+    if (i == 3) { hardware.buttonC.press(); }
+    if (i == 6) { hardware.buttonC.release(); }
+    traced.cIsPressed();
+    traced.aIsPressed();
+    JarHost::advanceMillis(1);
+  }
+  trace.stop();
+
+  JarTraceReader reader(serial.out, serial.outLength);
+  JarTraceRecord record;
+  TEST_ASSERT_TRUE(reader.next(record));
+  TEST_ASSERT_EQUAL(TRACE_HELD, record.type);
+  TEST_ASSERT_EQUAL(3, record.time);
+  TEST_ASSERT_EQUAL(TRACE_HELD_C, record.held);
+  TEST_ASSERT_TRUE(reader.next(record));
+  TEST_ASSERT_EQUAL(6, record.time);
+  TEST_ASSERT_EQUAL(0, record.held);
+  TEST_ASSERT_FALSE(reader.next(record));
+}
+
+// Button presses recorded to EEPROM outside any sensor loop reach
+// EEPROM rather than overflowing the buffer.
+void test_eeprom_trace_flushed_by_buttons()
+{
+  HostButtons hardware;
+  JarTracedButtons<HostButtons> traced(hardware, trace);
+  JarHost::clock() = 0;
+  trace.startEeprom();
+  for (uint8_t i = 0; i < 40; i++)
+  {
+    hardware.buttonA.press();
+    traced.monitor();
+    JarHost::advanceMillis(1);
+    hardware.buttonA.release();
+    traced.monitor();
+    JarHost::advanceMillis(1);
+  }
+  TEST_ASSERT_EQUAL_UINT16(0, trace.dropped);
+  trace.stop();
+
+  serial.outLength = 0;
+  JarTrace::dumpEeprom(serial);
+  JarTraceReader reader(serial.out, serial.outLength);
+  JarTraceRecord record;
+  uint8_t presses = 0;
+  while (reader.next(record))
+  {
+    presses += record.type == TRACE_BUTTON && record.button == 'A';
+  }
+  TEST_ASSERT_EQUAL_UINT8(40, presses);
+}
+
+// A trace longer than 64 KB decodes to the end.
+void test_reader_handles_long_traces()
+{
+  static uint8_t data[3 + 20000 * 4];
+  data[0] = TRACE_MAGIC_0;
+  data[1] = TRACE_MAGIC_1;
+  data[2] = TRACE_VERSION;
+  for (uint16_t i = 0; i < 20000; i++)
+  {
+    uint8_t *record = data + 3 + i * 4;
+    record[0] = TRACE_BATTERY;
+    record[1] = 1;
+    record[2] = i & 0xFF;
+    record[3] = i >> 8;
+  }
+
+  JarTraceReader reader(data, sizeof(data));
+  JarTraceRecord record;
+  uint16_t count = 0;
+  while (reader.next(record))
+  {
+    TEST_ASSERT_EQUAL_UINT16(count, record.battery.millivolts);
+    count++;
+  }
+  TEST_ASSERT_EQUAL_UINT16(20000, count);
+}
+
+// Room for about an hour and a half of serial capture.
+#define MAX_CAPTURE_BYTES (16UL << 20)
+
+// Replays a trace captured on the robot through the map loop and
+// prints what came out.
+void test_replay_captured_trace()
+{
+  const char *path = getenv("JAR_TRACE");
+  if (!path)
+  {
+    TEST_IGNORE_MESSAGE("set JAR_TRACE to a captured trace file");
+  }
+  static uint8_t data[MAX_CAPTURE_BYTES];
+  FILE *file = fopen(path, "rb");
+  TEST_ASSERT_TRUE_MESSAGE(file != 0, "cannot open JAR_TRACE");
+  size_t length = fread(data, 1, sizeof(data), file);
+  fclose(file);
+  TEST_ASSERT_TRUE_MESSAGE(length < sizeof(data), "JAR_TRACE is too long to replay in full");
+
+  resetBus();
+  JarReplay replay(data, length, bus);
+  TEST_ASSERT_TRUE_MESSAGE(replay.valid(), "not a trace");
+  uint32_t start = wallMicros();
+  uint32_t clockStart = JarHost::clock();
+  mapper.begin(bus, millis());
+  uint16_t updates = 0;
+  while (!replay.done())
+  {
+    replay.monitor();
+    updates += mapper.update(bus, millis());
+  }
+
+  char message[128];
+  snprintf(message, sizeof(message),
+           "%u records, %lu ms in %lu us, %u map updates, pose %ld,%ld mm, ahead %u",
+           (unsigned)replay.records, (unsigned long)(JarHost::clock() - clockStart) / 1000,
+           (unsigned long)(wallMicros() - start), updates, (long)(odometry.pose().x >> 8),
+           (long)(odometry.pose().y >> 8), mapper.ahead());
+  TEST_MESSAGE(message);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_replay_matches_live_run);
+  RUN_TEST(test_live_run_sees_the_wall);
+  RUN_TEST(test_replay_matches_live_demos);
+  RUN_TEST(test_live_demos_react);
+  RUN_TEST(test_encoder_records_are_rate_limited);
+  RUN_TEST(test_held_buttons_recorded_on_change);
+  RUN_TEST(test_eeprom_trace_flushed_by_buttons);
+  RUN_TEST(test_reader_handles_long_traces);
+  RUN_TEST(test_replay_captured_trace);
+  return UNITY_END();
+}
@@ -0,0 +1,171 @@
+"""Packs the strings, marquee texts and LCD glyphs listed in
+assets/jarAssets.txt into one indexed PROGMEM blob.
+
+Writes lib/JarAssets/jarAssetData.h (ids, offsets and lengths) and
+lib/JarAssets/jarAssetData.cpp (the blob and its index). Runs before
+every build as a PlatformIO extra script, or by hand:
+
+    python tools/gen_assets.py
+"""
+
+import os
+import re
+import sys
+
+LCD_WIDTH = 8
+GLYPH_ROWS = 8
+FLAG_RLE = 1
+
+SOURCE = os.path.join("assets", "jarAssets.txt")
+HEADER = os.path.join("lib", "JarAssets", "jarAssetData.h")
+SOURCE_FILE = os.path.join("lib", "JarAssets", "jarAssetData.cpp")
+
+STRING_RE = re.compile(r'^(string|marquee)\s+([A-Z][A-Z0-9_]*)\s+"((?:[^"\\]|\\.)*)"\s*$')
+CONTINUATION_RE = re.compile(r'^"((?:[^"\\]|\\.)*)"\s*$')
+GLYPH_RE = re.compile(r"^glyph\s+([A-Z][A-Z0-9_]*)\s*$")
+
+
+class Asset:
+    def __init__(self, kind, name, data):
+        self.kind = kind
+        self.name = name
+        self.length = len(data)
+        self.flags = 0
+        self.stored = data
+
+        if kind == "string" or kind == "marquee":
+            # Strings are NUL-terminated so they can be printed in place.
+            self.stored = data + b"\0"
+        elif kind == "glyph":
+            packed = rle(data)
+            if len(packed) < len(data):
+                self.stored = packed
+                self.flags = FLAG_RLE
+
+
+def rle(data):
+    """Encodes data as (count, byte) pairs."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < 255:
+            run += 1
+        out += bytes([run, data[i]])
+        i += run
+    return bytes(out)
+
+
+def unescape(text):
+    return text.encode("latin-1").decode("unicode_escape").encode("latin-1")
+
+
+def parse(path):
+    assets = []
+    names = set()
+    with open(path) as f:
+        lines = f.read().splitlines()
+
+    i = 0
+    while i < len(lines):
+        line = lines[i].strip()
+        i += 1
+        if not line or line.startswith("#"):
+            continue
+
+        m = STRING_RE.match(line)
+        if m:
+            kind, name, text = m.groups()
+            # Quoted lines right after it continue the text, so long
+            # tunes can be split like C string literals.
+            while i < len(lines):
+                more = CONTINUATION_RE.match(lines[i].strip())
+                if not more:
+                    break
+                text += more.group(1)
+                i += 1
+            data = unescape(text)
+            if kind == "marquee":
+                data = b" " * LCD_WIDTH + data + b" " * LCD_WIDTH
+            asset = Asset(kind, name, data)
+        else:
+            m = GLYPH_RE.match(line)
+            if not m:
+                sys.exit("%s:%d: cannot parse '%s'" % (path, i, line))
+            name = m.group(1)
+            rows = [r.strip() for r in lines[i:i + GLYPH_ROWS]]
+            i += GLYPH_ROWS
+            if len(rows) != GLYPH_ROWS or any(not re.match(r"^[.#]{5}$", r) for r in rows):
+                sys.exit("%s:%d: glyph %s needs %d rows of 5 '.' or '#'"
+                         % (path, i, name, GLYPH_ROWS))
+            data = bytes(int(r.replace(".", "0").replace("#", "1"), 2) for r in rows)
+            asset = Asset("glyph", name, data)
+
+        if asset.name in names:
+            sys.exit("%s:%d: duplicate asset %s" % (path, i, asset.name))
+        if asset.length > 65535:
+            sys.exit("%s:%d: asset %s is longer than 65535 bytes" % (path, i, asset.name))
+        names.add(asset.name)
+        assets.append(asset)
+    return assets
+
+
+def render(assets):
+    offset = 0
+    for asset in assets:
+        asset.offset = offset
+        offset += len(asset.stored)
+    size = offset
+
+    banner = "// Generated by tools/gen_assets.py from %s; do not edit.\n" % SOURCE.replace(os.sep, "/")
+
+    h = [banner, "#ifndef ASSET_DATA_H\n#define ASSET_DATA_H\n\n#include <Arduino.h>\n\n"]
+    h.append("enum JarAssetId : uint8_t\n{\n")
+    for asset in assets:
+        h.append("  ASSET_%s,\n" % asset.name)
+    h.append("  ASSET_COUNT\n};\n\n")
+    h.append("// Offsets are only defined for entries stored uncompressed.\n")
+    for asset in assets:
+        if not asset.flags & FLAG_RLE:
+            h.append("#define ASSET_%s_OFFSET %d\n" % (asset.name, asset.offset))
+        h.append("#define ASSET_%s_LENGTH %d\n" % (asset.name, asset.length))
+    h.append("\n#define ASSET_BLOB_SIZE %d\n\n" % size)
+    h.append("extern const uint8_t jarAssetBlob[ASSET_BLOB_SIZE] PROGMEM;\n\n#endif\n")
+
+    c = [banner, "#include <jarAssets.h>\n\n"]
+    c.append("const uint8_t jarAssetBlob[ASSET_BLOB_SIZE] PROGMEM = {\n")
+    for asset in assets:
+        c.append("    // %s %s\n" % (asset.kind, asset.name))
+        for i in range(0, len(asset.stored), 12):
+            chunk = asset.stored[i:i + 12]
+            c.append("    " + " ".join("0x%02x," % b for b in chunk) + "\n")
+    c.append("};\n\n")
+    c.append("const JarAssetEntry jarAssetIndex[ASSET_COUNT] PROGMEM = {\n")
+    for asset in assets:
+        c.append("    {%d, %d, %d},\n" % (asset.offset, asset.length, asset.flags))
+    c.append("};\n")
+    return "".join(h), "".join(c)
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def generate(project_dir):
+    assets = parse(os.path.join(project_dir, SOURCE))
+    header, source = render(assets)
+    write_if_changed(os.path.join(project_dir, HEADER), header)
+    write_if_changed(os.path.join(project_dir, SOURCE_FILE), source)
+
+
+try:
+    Import("env")  # noqa: F821 (defined when run by PlatformIO)
+    generate(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))